@@ -0,0 +1,118 @@
+#include "BatchFitter.h"
+#include "FitUtils.h"
+#include "Table.h"
+#include "WorkerPool.h"
+
+#include <TF1.h>
+#include <TH1.h>
+
+#include <iostream>
+
+/*!
+  \file BatchFitter.cxx
+  \brief fit the same function to a list of histograms
+*/
+
+//__________________________________________________________________
+const std::vector<BatchFitter::Result>& BatchFitter::Fit( const std::vector<TH1*>& histograms )
+{
+
+  fResults.clear();
+  if( !fFunction )
+  {
+    std::cout << "BatchFitter::Fit - function not set" << std::endl;
+    return fResults;
+  }
+
+  fResults.resize( histograms.size() );
+
+  // fits only run in parallel when neither the fitter nor the minimizer has shared state
+  const bool threadSafe( UTILS::FitUtils::IsThreadSafe( fOption ) );
+  const unsigned int nWorkers = threadSafe ?
+    WorkerPool::GetNWorkers( fNWorkers, histograms.size() ):1;
+  if( !threadSafe && fNWorkers != 1 )
+  { std::cout << "BatchFitter::Fit - fitter or minimizer is not thread safe. Using one worker" << std::endl; }
+  if( nWorkers > 1 ) ROOT::EnableThreadSafety();
+
+  std::cout << "BatchFitter::Fit - histograms: " << histograms.size() << " workers: " << nWorkers << std::endl;
+
+  // one function per worker, created from the main thread
+  std::vector<TF1*> functions;
+  for( unsigned int worker = 0; worker < nWorkers; ++worker )
+  { functions.push_back( static_cast<TF1*>( fFunction->Clone( Form( "%s_batch_%i", fFunction->GetName(), worker ) ) ) ); }
+
+  // do not draw, do not store function in histograms, do not print
+  const TString option = fOption + "Q0N";
+  WorkerPool::Run( nWorkers, histograms.size(),
+    [&]( unsigned int worker, unsigned int first, unsigned int end )
+    {
+      TF1* f = functions[worker];
+      const int nPar = f->GetNpar();
+
+      // parameters of the last successful fit in this chunk, starting from the function initial values
+      std::vector<double> parameters( f->GetParameters(), f->GetParameters() + nPar );
+      for( unsigned int i = first; i < end; ++i )
+      {
+        if( !histograms[i] ) continue;
+
+        // warm start
+        f->SetParameters( parameters.data() );
+
+        Result& result( fResults[i] );
+        result.fStatus = UTILS::FitUtils::Fit( histograms[i], f, option );
+        result.fChisquare = f->GetChisquare();
+        result.fNDF = f->GetNDF();
+        for( int iP = 0; iP < nPar; ++iP )
+        {
+          result.fParameters.push_back( f->GetParameter( iP ) );
+          result.fErrors.push_back( f->GetParError( iP ) );
+        }
+
+        if( result.fStatus == 0 ) parameters = result.fParameters;
+      }
+    } );
+
+  for( auto f:functions ) delete f;
+  return fResults;
+
+}
+
+//__________________________________________________________________
+Table* BatchFitter::GetTable( void ) const
+{
+
+  const int nLines = fResults.size();
+  const int nPar = fFunction ? fFunction->GetNpar():0;
+
+  std::vector<double> values( nLines );
+  std::vector<double> errors( nLines );
+
+  Table* table = new Table();
+  for( int i = 0; i < nLines; ++i ) values[i] = i;
+  table->AddColumn( "index", values.data(), nLines, "%.0f" );
+
+  for( int iP = 0; iP < nPar; ++iP )
+  {
+    for( int i = 0; i < nLines; ++i )
+    {
+      const bool valid( int( fResults[i].fParameters.size() ) > iP );
+      values[i] = valid ? fResults[i].fParameters[iP]:0;
+      errors[i] = valid ? fResults[i].fErrors[iP]:0;
+    }
+
+    table->AddColumn( fFunction->GetParName( iP ), values.data(), nLines, "%.4g" );
+    table->AddErrorColumn( "", errors.data(), nLines, "%.4g" );
+  }
+
+  for( int i = 0; i < nLines; ++i ) values[i] = fResults[i].fChisquare;
+  table->AddColumn( "chi2", values.data(), nLines, "%.4g" );
+
+  for( int i = 0; i < nLines; ++i ) values[i] = fResults[i].fNDF;
+  table->AddColumn( "ndf", values.data(), nLines, "%.0f" );
+
+  for( int i = 0; i < nLines; ++i ) values[i] = fResults[i].fStatus;
+  table->AddColumn( "status", values.data(), nLines, "%.0f" );
+
+  return table;
+
+}
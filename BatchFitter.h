@@ -0,0 +1,103 @@
+#ifndef BatchFitter_h
+#define BatchFitter_h
+
+/*!
+\file    BatchFitter.h
+\brief   fit the same function to a list of histograms
+*/
+
+#include <TROOT.h>
+#include <TObject.h>
+#include <TString.h>
+
+#include <vector>
+
+class Table;
+class TF1;
+class TH1;
+
+/*!
+\class   BatchFitter
+\brief   fit the same function to a list of histograms
+
+Histograms are split into contiguous chunks, fitted in parallel, one chunk
+per worker. Inside a chunk, each fit starts from the parameters of the
+last successful fit, or from the function initial values. Fits are performed
+using FitUtils::Fit, in quiet mode. They only run in parallel when
+FitUtils::IsThreadSafe, that is with Minuit2 as default minimizer and no local fitter.
+*/
+class BatchFitter
+{
+
+  public:
+
+  //! fit result for one histogram
+  class Result
+  {
+    public:
+
+    //! constructor
+    Result( void ):
+      fChisquare( 0 ),
+      fNDF( 0 ),
+      fStatus( -1 )
+    {}
+
+    //! parameters
+    std::vector<double> fParameters;
+
+    //! errors
+    std::vector<double> fErrors;
+
+    //! chisquare
+    double fChisquare;
+
+    //! number of degrees of freedom
+    int fNDF;
+
+    //! fit status
+    int fStatus;
+
+  };
+
+  //! constructor
+  BatchFitter( TF1* f, TString option = "" ):
+    fFunction( f ),
+    fOption( option ),
+    fNWorkers( 0 )
+  {}
+
+  //! number of workers. Zero means one per hardware thread
+  void SetNWorkers( unsigned int value )
+  { fNWorkers = value; }
+
+  //! fit all histograms, in order
+  const std::vector<Result>& Fit( const std::vector<TH1*>& histograms );
+
+  //! results from last fit
+  const std::vector<Result>& GetResults( void ) const
+  { return fResults; }
+
+  /*!
+  results from last fit in table format: index, parameters with errors, chisquare, ndf and status.
+  the table must be deleted by the calling method
+  */
+  Table* GetTable( void ) const;
+
+  private:
+
+  //! function
+  TF1* fFunction;
+
+  //! fit option
+  TString fOption;
+
+  //! number of workers
+  unsigned int fNWorkers;
+
+  //! results
+  std::vector<Result> fResults;
+
+};
+
+#endif
@@ -0,0 +1,6 @@
+#ifdef __CINT__
+
+#pragma link C++ class BatchFitter;
+#pragma link C++ class BatchFitter::Result;
+
+#endif
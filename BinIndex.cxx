@@ -0,0 +1,129 @@
+#include "BinIndex.h"
+
+#include <TAxis.h>
+#include <TF1.h>
+#include <TH1.h>
+#include <THnBase.h>
+
+#include <iostream>
+
+/*!
+  \file BinIndex.cxx
+  \brief list of active bins for fits
+*/
+
+//__________________________________________________________________
+void BinIndex::Add( TF1* f, bool chisquare, const double* x, double content, double error, Long64_t bin )
+{
+
+  if( f && !f->IsInside( x ) ) return;
+  if( chisquare && error <= 0 ) return;
+
+  Entry entry;
+  for( int i = 0; i < 3; ++i ) entry.fX[i] = x[i];
+  entry.fContent = content;
+  entry.fError = error;
+  entry.fBin = bin;
+  fEntries.push_back( entry );
+
+}
+
+//__________________________________________________________________
+void BinIndex::Build( TH1* h, TF1* f, bool chisquare, const TH1* mask )
+{
+
+  Clear();
+  if( !h ) return;
+  fHistogram = h;
+
+  if( mask && mask->GetNcells() != h->GetNcells() )
+  {
+    std::cout << "BinIndex::Build - mask binning does not match histogram. Ignored" << std::endl;
+    mask = 0;
+  }
+
+  double x[3];
+  for( int binX = h->GetXaxis()->GetFirst(); binX <= h->GetXaxis()->GetLast(); ++binX )
+    for( int binY = h->GetYaxis()->GetFirst(); binY <= h->GetYaxis()->GetLast(); ++binY )
+    for( int binZ = h->GetZaxis()->GetFirst(); binZ <= h->GetZaxis()->GetLast(); ++binZ )
+  {
+
+    const int bin( h->GetBin( binX, binY, binZ ) );
+    if( mask && !mask->GetBinContent( bin ) ) continue;
+
+    x[0] = h->GetXaxis()->GetBinCenter( binX );
+    x[1] = h->GetYaxis()->GetBinCenter( binY );
+    x[2] = h->GetZaxis()->GetBinCenter( binZ );
+    Add( f, chisquare, x, h->GetBinContent( bin ), h->GetBinError( bin ), bin );
+
+  }
+
+}
+
+//__________________________________________________________________
+void BinIndex::Build( THnBase* h, TF1* f, bool chisquare )
+{
+
+  Clear();
+  if( !h ) return;
+
+  const int nDim = h->GetNdimensions();
+  if( nDim > 3 )
+  {
+    std::cout << "BinIndex::Build - cannot handle " << nDim << " dimensions" << std::endl;
+    return;
+  }
+
+  fHistogram = h;
+
+  int first[3] = { 0, 0, 0 };
+  int last[3] = { 0, 0, 0 };
+  for( int i = 0; i < nDim; ++i )
+  {
+    first[i] = h->GetAxis( i )->GetFirst();
+    last[i] = h->GetAxis( i )->GetLast();
+  }
+
+  double x[3] = { 0, 0, 0 };
+  int coord[3] = { 0, 0, 0 };
+  if( chisquare )
+  {
+
+    // only loop over filled bins
+    for( Long64_t bin = 0; bin < h->GetNbins(); ++bin )
+    {
+
+      const double content( h->GetBinContent( bin, coord ) );
+
+      bool inside( true );
+      for( int i = 0; i < nDim && inside; ++i )
+      {
+        inside = coord[i] >= first[i] && coord[i] <= last[i];
+        x[i] = h->GetAxis( i )->GetBinCenter( coord[i] );
+      }
+
+      if( inside ) Add( f, chisquare, x, content, h->GetBinError( bin ), bin );
+
+    }
+
+  } else {
+
+    // empty bins contribute to the likelihood, loop over all bins in range
+    for( coord[0] = first[0]; coord[0] <= last[0]; ++coord[0] )
+      for( coord[1] = first[1]; coord[1] <= last[1]; ++coord[1] )
+      for( coord[2] = first[2]; coord[2] <= last[2]; ++coord[2] )
+    {
+
+      for( int i = 0; i < nDim; ++i )
+      { x[i] = h->GetAxis( i )->GetBinCenter( coord[i] ); }
+
+      // do not allocate missing bins in sparse histograms
+      const Long64_t bin( h->GetBin( coord, kFALSE ) );
+      if( bin < 0 ) Add( f, chisquare, x, 0, 0, bin );
+      else Add( f, chisquare, x, h->GetBinContent( bin ), h->GetBinError( bin ), bin );
+
+    }
+
+  }
+
+}
@@ -0,0 +1,106 @@
+#ifndef BinIndex_h
+#define BinIndex_h
+
+/*!
+\file    BinIndex.h
+\brief   list of active bins for fits
+*/
+
+#include <TROOT.h>
+#include <TObject.h>
+
+#include <vector>
+
+class TF1;
+class TH1;
+class THnBase;
+
+/*!
+\class   BinIndex
+\brief   list of active bins for fits
+
+Bins are selected once per fit from the histogram axis ranges, the function
+range (TF1::IsInside) and an optional mask histogram with the same binning, for
+which bins with zero content are excluded. For each selected bin the center,
+content and error are stored contiguously, so that fit functions only loop over
+active bins.
+
+In chisquare mode bins with zero error are also excluded. In likelihood mode
+they are kept, since empty bins contribute through the predicted content.
+
+THnBase inputs with up to three dimensions are supported. In chisquare mode only
+filled bins are visited, which for THnSparse is the number of filled bins rather
+than the full grid.
+*/
+class BinIndex
+{
+
+  public:
+
+  //! one active bin
+  class Entry
+  {
+    public:
+
+    //! bin center
+    double fX[3];
+
+    //! bin content
+    double fContent;
+
+    //! bin error
+    double fError;
+
+    //! global bin index in histogram
+    Long64_t fBin;
+  };
+
+  //! constructor
+  BinIndex( void ):
+    fHistogram( 0 )
+  {}
+
+  //! constructor from histogram
+  BinIndex( TH1* h, TF1* f, bool chisquare = true, const TH1* mask = 0 ):
+    fHistogram( 0 )
+  { Build( h, f, chisquare, mask ); }
+
+  //! clear
+  void Clear( void )
+  {
+    fHistogram = 0;
+    fEntries.clear();
+  }
+
+  //! select active bins from histogram
+  void Build( TH1* h, TF1* f, bool chisquare = true, const TH1* mask = 0 );
+
+  //! select active bins from n-dimensional histogram
+  void Build( THnBase* h, TF1* f, bool chisquare = true );
+
+  //! histogram from which the index was built
+  const TObject* GetHistogram( void ) const
+  { return fHistogram; }
+
+  //! number of active bins
+  int GetSize( void ) const
+  { return fEntries.size(); }
+
+  //! active bins
+  const std::vector<Entry>& GetEntries( void ) const
+  { return fEntries; }
+
+  private:
+
+  //! add bin, if inside function range and with valid error
+  void Add( TF1* f, bool chisquare, const double* x, double content, double error, Long64_t bin );
+
+  //! histogram
+  const TObject* fHistogram;
+
+  //! active bins
+  std::vector<Entry> fEntries;
+
+};
+
+#endif
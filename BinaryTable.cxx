@@ -0,0 +1,486 @@
+#include "BinaryTable.h"
+#include "MappedFile.h"
+#include "Table.h"
+
+#include <RZip.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+/*!
+  \file BinaryTable.cxx
+  \brief binary columnar table file, memory mapped
+*/
+
+namespace
+{
+
+  //* magic string
+  const char magic[8] = { 'R', 'U', 'T', 'A', 'B', 'L', 'E', 0 };
+
+  //* format version
+  const uint32_t version = 1;
+
+  //* byte order mark
+  const uint32_t byteOrder = 0x01020304;
+
+  //* block alignment
+  const uint64_t alignment = 64;
+
+  //* maximum size of compressed pieces, as accepted by R__zip
+  const int maxPieceSize = 0xffffff;
+
+  //* file header
+  struct FileHeader
+  {
+    char fMagic[8];
+    uint32_t fVersion;
+    uint32_t fByteOrder;
+    uint32_t fNColumns;
+    uint32_t fReserved;
+    uint64_t fNRows;
+  };
+
+  //* column header. Followed by name, format and alignment strings
+  struct ColumnHeader
+  {
+    uint32_t fKind;
+    int32_t fType;
+    uint32_t fCompression;
+    uint32_t fNameLength;
+    uint32_t fFormatLength;
+    uint32_t fAlignmentLength;
+    uint64_t fOffset;
+    uint64_t fSize;
+    uint64_t fRawSize;
+  };
+
+  //* compressed piece header
+  struct PieceHeader
+  {
+    uint32_t fSize;
+    uint32_t fRawSize;
+  };
+
+  //* round up to alignment
+  uint64_t Align( uint64_t offset )
+  { return ( offset + alignment - 1 )/alignment*alignment; }
+
+  //* append raw bytes
+  void Append( std::vector<char>& out, const void* data, size_t size )
+  {
+    const char* begin = static_cast<const char*>( data );
+    out.insert( out.end(), begin, begin + size );
+  }
+
+  //* append values of a numeric column. Returns false if column type does not match
+  template<typename T> bool AppendValues( const ColumnBase* column, uint64_t nRows, std::vector<char>& block )
+  {
+    const Column<T>* typed = dynamic_cast<const Column<T>*>( column );
+    if( !typed ) return false;
+    Append( block, typed->GetValues().data(), nRows*sizeof( T ) );
+    return true;
+  }
+
+  //* create numeric column from values, copied at once
+  template<typename T, typename C> ColumnBase* NewColumn( const T* values, Long64_t size )
+  {
+    C* column = new C();
+    column->Append( std::vector<T>( values, values + size ) );
+    return column;
+  }
+
+  //* string from a checked string block
+  TString GetBlockString( const char* block, uint64_t nRows, uint64_t row )
+  {
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>( block );
+    const char* characters = block + ( nRows+1 )*sizeof( uint64_t );
+    return TString( characters + offsets[row], offsets[row+1] - offsets[row] );
+  }
+
+  //* compress block in independent pieces. Pieces that do not compress are stored as is
+  std::vector<char> Compress( const std::vector<char>& in, int compression )
+  {
+    std::vector<char> out;
+    std::vector<char> buffer( std::min<size_t>( in.size(), maxPieceSize ) );
+    for( size_t offset = 0; offset < in.size(); offset += maxPieceSize )
+    {
+      int rawSize = std::min<size_t>( in.size() - offset, maxPieceSize );
+      int size = rawSize;
+      int stored = 0;
+      R__zip( compression, &rawSize, const_cast<char*>( &in[offset] ), &size, &buffer[0], &stored );
+
+      PieceHeader header;
+      header.fRawSize = rawSize;
+      if( stored > 0 && stored < rawSize )
+      {
+        header.fSize = stored;
+        Append( out, &header, sizeof( header ) );
+        Append( out, &buffer[0], stored );
+      } else {
+        header.fSize = rawSize;
+        Append( out, &header, sizeof( header ) );
+        Append( out, &in[offset], rawSize );
+      }
+    }
+
+    return out;
+  }
+
+  //* decompress block. Returns false on error
+  bool Decompress( const char* in, uint64_t size, std::vector<char>& out, uint64_t rawSize )
+  {
+    out.resize( rawSize );
+    uint64_t offset = 0;
+    uint64_t rawOffset = 0;
+    while( rawOffset < rawSize )
+    {
+      PieceHeader header;
+      if( offset + sizeof( header ) > size ) return false;
+      memcpy( &header, in + offset, sizeof( header ) );
+      offset += sizeof( header );
+      if( offset + header.fSize > size || rawOffset + header.fRawSize > rawSize ) return false;
+
+      if( header.fSize == header.fRawSize ) memcpy( &out[rawOffset], in + offset, header.fSize );
+      else {
+        int pieceSize = header.fSize;
+        int pieceRawSize = header.fRawSize;
+        int unpacked = 0;
+        R__unzip(
+          &pieceSize, reinterpret_cast<unsigned char*>( const_cast<char*>( in + offset ) ),
+          &pieceRawSize, reinterpret_cast<unsigned char*>( &out[rawOffset] ), &unpacked );
+        if( unpacked != int( header.fRawSize ) ) return false;
+      }
+
+      offset += header.fSize;
+      rawOffset += header.fRawSize;
+    }
+
+    return true;
+  }
+
+  //* check that string offsets increase and stay inside the block. Block size includes the nRows+1 offsets
+  bool CheckStringOffsets( const char* block, uint64_t nRows, uint64_t rawSize )
+  {
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>( block );
+    const uint64_t size = rawSize - ( nRows+1 )*sizeof( uint64_t );
+    if( offsets[0] > size ) return false;
+    for( uint64_t row = 0; row < nRows; ++row )
+    { if( offsets[row] > offsets[row+1] || offsets[row+1] > size ) return false; }
+    return true;
+  }
+
+}
+
+//__________________________________________________________________
+BinaryTable::BinaryTable( const char* filename ):
+  fValid( false ),
+  fFile( new MappedFile( filename ) ),
+  fNRows( 0 )
+{
+
+  if( !fFile->IsValid() )
+  {
+    std::cout << "BinaryTable::BinaryTable - invalid file: " << ( filename ? filename:"" ) << std::endl;
+    return;
+  }
+
+  // file header
+  const char* data = fFile->GetData();
+  const uint64_t size = fFile->GetSize();
+  FileHeader fileHeader;
+  if( size < sizeof( fileHeader ) )
+  {
+    std::cout << "BinaryTable::BinaryTable - file too short: " << filename << std::endl;
+    return;
+  }
+
+  memcpy( &fileHeader, data, sizeof( fileHeader ) );
+  if( memcmp( fileHeader.fMagic, magic, sizeof( magic ) ) != 0 )
+  {
+    std::cout << "BinaryTable::BinaryTable - not a table file: " << filename << std::endl;
+    return;
+  }
+
+  if( fileHeader.fVersion != version || fileHeader.fByteOrder != byteOrder )
+  {
+    std::cout << "BinaryTable::BinaryTable - unsupported version or byte order: " << filename << std::endl;
+    return;
+  }
+
+  // rows are indexed with int in table columns
+  if( fileHeader.fNRows > uint64_t( std::numeric_limits<int>::max() ) )
+  {
+    std::cout << "BinaryTable::BinaryTable - invalid number of rows: " << fileHeader.fNRows << " in " << filename << std::endl;
+    return;
+  }
+
+  fNRows = fileHeader.fNRows;
+
+  // column headers
+  uint64_t offset = sizeof( fileHeader );
+  for( uint32_t i = 0; i < fileHeader.fNColumns; ++i )
+  {
+
+    ColumnHeader header;
+    if( offset + sizeof( header ) > size ) break;
+    memcpy( &header, data + offset, sizeof( header ) );
+    offset += sizeof( header );
+
+    // sizes are compared by subtraction and division, which cannot overflow
+    const uint64_t stringSize = uint64_t( header.fNameLength ) + header.fFormatLength + header.fAlignmentLength;
+    if( stringSize > size - offset ) break;
+    if( header.fOffset > size || header.fSize > size - header.fOffset ) break;
+
+    // uncompressed size must match the number of rows
+    if( header.fKind > kBool ) break;
+    if( header.fKind == kString && header.fRawSize/sizeof( uint64_t ) <= fileHeader.fNRows ) break;
+    if( header.fKind != kString )
+    {
+      const size_t valueSize = GetValueSize( header.fKind );
+      if( header.fRawSize % valueSize || header.fRawSize/valueSize != fileHeader.fNRows ) break;
+    }
+
+    // each compressed piece holds at most maxPieceSize bytes, after its own header
+    if( header.fCompression == kNone && header.fSize != header.fRawSize ) break;
+    if( header.fCompression != kNone && header.fRawSize/maxPieceSize > header.fSize/sizeof( PieceHeader ) ) break;
+
+    // string offsets of uncompressed columns are checked once here, compressed ones when decompressed
+    if( header.fKind == kString && header.fCompression == kNone && !CheckStringOffsets( data + header.fOffset, fileHeader.fNRows, header.fRawSize ) ) break;
+
+    ColumnInfo column;
+    column.fName = TString( data + offset, header.fNameLength );
+    offset += header.fNameLength;
+    column.fFormat = TString( data + offset, header.fFormatLength );
+    offset += header.fFormatLength;
+    column.fAlignment = TString( data + offset, header.fAlignmentLength );
+    offset += header.fAlignmentLength;
+
+    column.fKind = header.fKind;
+    column.fType = header.fType;
+    column.fCompression = header.fCompression;
+    column.fData = data + header.fOffset;
+    column.fSize = header.fSize;
+    column.fRawSize = header.fRawSize;
+    fColumns.push_back( column );
+
+  }
+
+  if( fColumns.size() != fileHeader.fNColumns )
+  {
+    std::cout << "BinaryTable::BinaryTable - truncated or invalid file: " << filename << std::endl;
+    fColumns.clear();
+    return;
+  }
+
+  fBuffers.resize( fColumns.size() );
+  fValid = true;
+
+}
+
+//__________________________________________________________________
+BinaryTable::~BinaryTable( void )
+{}
+
+//__________________________________________________________________
+bool BinaryTable::Write( const Table& table, const char* filename, int compression )
+{
+
+  const int nColumns = table.GetNColumns();
+  const uint64_t nRows = nColumns ? table.GetNLines():0;
+
+  // column blocks
+  std::vector<ColumnHeader> headers( nColumns );
+  std::vector< std::vector<char> > blocks( nColumns );
+  for( int i = 0; i < nColumns; ++i )
+  {
+
+    const ColumnBase* column = table.GetColumn( i );
+    ColumnHeader& header = headers[i];
+    std::vector<char>& block = blocks[i];
+
+    if( AppendValues<double>( column, nRows, block ) ) header.fKind = kDouble;
+    else if( AppendValues<int>( column, nRows, block ) ) header.fKind = kInt;
+    else if( AppendValues<float>( column, nRows, block ) ) header.fKind = kFloat;
+    else if( AppendValues<unsigned char>( column, nRows, block ) ) header.fKind = kBool;
+    else if( const ColumnString* columnString = dynamic_cast<const ColumnString*>( column ) ) {
+
+      header.fKind = kString;
+      const std::vector<TString>& values( columnString->GetValues() );
+      std::vector<uint64_t> offsets( 1, 0 );
+      for( uint64_t row = 0; row < nRows; ++row ) offsets.push_back( offsets.back() + values[row].Length() );
+      Append( block, offsets.data(), offsets.size()*sizeof( uint64_t ) );
+      for( uint64_t row = 0; row < nRows; ++row ) Append( block, values[row].Data(), values[row].Length() );
+
+    } else {
+
+      std::cout << "BinaryTable::Write - unsupported type for column " << i << std::endl;
+      return false;
+
+    }
+
+    header.fType = column->GetType();
+    header.fNameLength = column->GetName().Length();
+    header.fFormatLength = column->GetFormat().Length();
+    header.fAlignmentLength = column->GetAlignment().Length();
+    header.fRawSize = block.size();
+    header.fCompression = kNone;
+    if( compression > 0 && !block.empty() )
+    {
+      block = Compress( block, compression );
+      header.fCompression = kZip;
+    }
+
+    header.fSize = block.size();
+
+  }
+
+  // block offsets
+  uint64_t offset = sizeof( FileHeader );
+  for( int i = 0; i < nColumns; ++i )
+  { offset += sizeof( ColumnHeader ) + headers[i].fNameLength + headers[i].fFormatLength + headers[i].fAlignmentLength; }
+
+  for( int i = 0; i < nColumns; ++i )
+  {
+    offset = Align( offset );
+    headers[i].fOffset = offset;
+    offset += headers[i].fSize;
+  }
+
+  // write
+  std::ofstream out( filename, std::ios::binary );
+  if( !out )
+  {
+    std::cout << "BinaryTable::Write - invalid file: " << filename << std::endl;
+    return false;
+  }
+
+  FileHeader fileHeader;
+  memcpy( fileHeader.fMagic, magic, sizeof( magic ) );
+  fileHeader.fVersion = version;
+  fileHeader.fByteOrder = byteOrder;
+  fileHeader.fNColumns = nColumns;
+  fileHeader.fReserved = 0;
+  fileHeader.fNRows = nRows;
+  out.write( reinterpret_cast<const char*>( &fileHeader ), sizeof( fileHeader ) );
+
+  for( int i = 0; i < nColumns; ++i )
+  {
+    const ColumnBase* column = table.GetColumn( i );
+    out.write( reinterpret_cast<const char*>( &headers[i] ), sizeof( ColumnHeader ) );
+    out.write( column->GetName().Data(), headers[i].fNameLength );
+    out.write( column->GetFormat().Data(), headers[i].fFormatLength );
+    out.write( column->GetAlignment().Data(), headers[i].fAlignmentLength );
+  }
+
+  const char padding[alignment] = { 0 };
+  for( int i = 0; i < nColumns; ++i )
+  {
+    out.write( padding, headers[i].fOffset - uint64_t( out.tellp() ) );
+    out.write( blocks[i].data(), blocks[i].size() );
+  }
+
+  return bool( out );
+
+}
+
+//__________________________________________________________________
+const char* BinaryTable::GetBlock( int column ) const
+{
+
+  const ColumnInfo& info( fColumns[column] );
+  if( info.fCompression == kNone ) return info.fData;
+
+  // decompressed block is cached
+  std::vector<char>& buffer( fBuffers[column] );
+  if( buffer.size() == info.fRawSize ) return buffer.data();
+
+  if( !Decompress( info.fData, info.fSize, buffer, info.fRawSize ) )
+  {
+    std::cout << "BinaryTable::GetBlock - cannot decompress column " << column << std::endl;
+    buffer.clear();
+    return 0;
+  }
+
+  // string offsets are checked once, when the block is decompressed
+  if( info.fKind == kString && !CheckStringOffsets( buffer.data(), fNRows, info.fRawSize ) )
+  {
+    std::cout << "BinaryTable::GetBlock - invalid string offsets in column " << column << std::endl;
+    buffer.clear();
+    return 0;
+  }
+
+  return buffer.data();
+
+}
+
+//__________________________________________________________________
+size_t BinaryTable::GetValueSize( int kind )
+{
+  switch( kind )
+  {
+    case kDouble: return sizeof( double );
+    case kInt: return sizeof( int );
+    case kFloat: return sizeof( float );
+    case kBool: return sizeof( unsigned char );
+    default: return 0;
+  }
+}
+
+//__________________________________________________________________
+TString BinaryTable::GetString( int column, Long64_t row ) const
+{
+  if( GetKind( column ) != kString ) return TString();
+  const char* block = GetBlock( column );
+  return block ? GetBlockString( block, fNRows, row ):TString();
+}
+
+//__________________________________________________________________
+void BinaryTable::Fill( Table& table ) const
+{
+
+  for( int i = 0; i < GetNColumns(); ++i )
+  {
+
+    const ColumnInfo& info( fColumns[i] );
+    ColumnBase* column = 0;
+    if( info.fKind == kString )
+    {
+
+      // block is decompressed and checked once for all rows. Columns that fail are skipped
+      const char* block = GetBlock( i );
+      if( !block ) continue;
+
+      std::vector<TString> values;
+      values.reserve( fNRows );
+      for( Long64_t row = 0; row < fNRows; ++row ) values.push_back( GetBlockString( block, fNRows, row ) );
+
+      ColumnString* columnString = new ColumnString();
+      columnString->Append( std::move( values ) );
+      column = columnString;
+
+    } else {
+
+      if( fNRows && !GetBlock( i ) ) continue;
+      switch( info.fKind )
+      {
+        case kDouble: column = NewColumn<double, ColumnDouble>( GetArray<double>( i ), fNRows ); break;
+        case kInt: column = NewColumn<int, ColumnInt>( GetArray<int>( i ), fNRows ); break;
+        case kFloat: column = NewColumn<float, ColumnFloat>( GetArray<float>( i ), fNRows ); break;
+        default: column = NewColumn<unsigned char, ColumnBool>( GetArray<unsigned char>( i ), fNRows ); break;
+      }
+
+    }
+
+    column->SetName( info.fName );
+    column->SetFormat( info.fFormat );
+    column->SetType( info.fType );
+    column->SetAlignment( info.fAlignment );
+    table.AddColumn( column );
+
+  }
+
+}
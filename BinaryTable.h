@@ -0,0 +1,206 @@
+#ifndef BinaryTable_h
+#define BinaryTable_h
+
+/*!
+\file    BinaryTable.h
+\brief   binary columnar table file, memory mapped
+*/
+
+#include <TROOT.h>
+#include <TString.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class MappedFile;
+class Table;
+
+/*!
+\class   BinaryTable
+\brief   binary columnar table file, memory mapped
+
+File layout, in native byte order:
+- a file header: magic string, version, byte order mark, number of columns and rows
+- one header per column: value kind, ColumnBase::ColumnType flags,
+compression, block offset and sizes, followed by column name, format and alignment
+- one block per column, starting at a 64 byte boundary. Numeric columns (double, int, float,
+and boolean as one byte) store the values contiguously. String columns store nRows+1
+offsets followed by the characters.
+
+Blocks are optionally compressed, using R__zip, in independent pieces of at most 16 MB.
+
+The reader maps the file. Uncompressed numeric columns are returned as pointers into the
+mapping, with no copy. Compressed columns are decompressed on first access and kept for
+the lifetime of the reader.
+*/
+class BinaryTable
+{
+
+  public:
+
+  //! constructor. Maps and checks the file
+  BinaryTable( const char* filename );
+
+  //! destructor
+  ~BinaryTable( void );
+
+  //! write table. Compression follows ROOT compression settings, zero for none
+  static bool Write( const Table& table, const char* filename, int compression = 0 );
+
+  //! true if file could be read
+  bool IsValid( void ) const
+  { return fValid; }
+
+  //! number of columns
+  int GetNColumns( void ) const
+  { return fColumns.size(); }
+
+  //! number of rows
+  Long64_t GetNRows( void ) const
+  { return fNRows; }
+
+  //! column name
+  const TString& GetName( int column ) const
+  { return fColumns[column].fName; }
+
+  //! column format
+  const TString& GetFormat( int column ) const
+  { return fColumns[column].fFormat; }
+
+  //! column alignment
+  const TString& GetAlignment( int column ) const
+  { return fColumns[column].fAlignment; }
+
+  //! column type flags, as in ColumnBase
+  int GetType( int column ) const
+  { return fColumns[column].fType; }
+
+  //! value kind, see Kind
+  int GetKind( int column ) const
+  { return fColumns[column].fKind; }
+
+  //! true for double columns
+  bool IsDouble( int column ) const
+  { return fColumns[column].fKind == kDouble; }
+
+  //! values of a double column. Null for other columns
+  const double* GetDoubleArray( int column ) const
+  { return GetArray<double>( column ); }
+
+  /*!
+  values of a numeric column. Null if the type does not match the column kind:
+  double, int, float, or unsigned char for boolean columns
+  */
+  template<typename T> const T* GetArray( int column ) const
+  { return fColumns[column].fKind == static_cast<uint32_t>( GetKind( static_cast<const T*>( 0 ) ) ) ? reinterpret_cast<const T*>( GetBlock( column ) ):0; }
+
+  //! value of a string column
+  TString GetString( int column, Long64_t row ) const;
+
+  //! add all columns to table. Values are copied. Columns that cannot be decompressed are skipped
+  void Fill( Table& table ) const;
+
+  //! value kinds
+  enum Kind
+  {
+    kDouble = 0,
+    kString = 1,
+    kInt = 2,
+    kFloat = 3,
+    kBool = 4
+  };
+
+  //! kind matching value type
+  static int GetKind( const double* )
+  { return kDouble; }
+
+  //! kind matching value type
+  static int GetKind( const int* )
+  { return kInt; }
+
+  //! kind matching value type
+  static int GetKind( const float* )
+  { return kFloat; }
+
+  //! kind matching value type
+  static int GetKind( const unsigned char* )
+  { return kBool; }
+
+  //! size of one value, for numeric kinds. Zero for strings
+  static size_t GetValueSize( int kind );
+
+  //! compression
+  enum Compression
+  {
+    kNone = 0,
+    kZip = 1
+  };
+
+  private:
+
+  //! column description
+  class ColumnInfo
+  {
+    public:
+
+    //! constructor
+    ColumnInfo( void ):
+      fKind( kDouble ),
+      fType( 0 ),
+      fCompression( kNone ),
+      fData( 0 ),
+      fSize( 0 ),
+      fRawSize( 0 )
+    {}
+
+    //! name
+    TString fName;
+
+    //! format
+    TString fFormat;
+
+    //! alignment
+    TString fAlignment;
+
+    //! kind
+    uint32_t fKind;
+
+    //! type flags
+    int fType;
+
+    //! compression
+    uint32_t fCompression;
+
+    //! stored block
+    const char* fData;
+
+    //! stored size
+    uint64_t fSize;
+
+    //! uncompressed size
+    uint64_t fRawSize;
+
+  };
+
+  //! uncompressed block of column. Decompressed on first call
+  const char* GetBlock( int column ) const;
+
+  //! true if file could be read
+  bool fValid;
+
+  //! mapped file
+  std::unique_ptr<MappedFile> fFile;
+
+  //! number of rows
+  Long64_t fNRows;
+
+  //! columns
+  std::vector<ColumnInfo> fColumns;
+
+  //! decompressed blocks, per column
+  mutable std::vector< std::vector<char> > fBuffers;
+
+};
+
+#endif
@@ -1,4 +1,7 @@
 #include "ChisquareFitter.h"
+#include "BinIndex.h"
+#include "FitMonitor.h"
+#include "Reduction.h"
 
 #include "ROOT_MACRO.h"
 
@@ -7,6 +10,9 @@
 #include <TMath.h>
 #include <TVirtualFitter.h>
 
+//_______________________________________________________________________________
+const BinIndex* ChisquareFitter::fBinIndex = 0;
+
 //_______________________________________________________________________________
 void ChisquareFitter::Fcn(
 int& npar,
@@ -16,6 +22,10 @@ double* u,
 int flag )
 {
 
+    // performance monitoring
+    const bool monitor( FitMonitor::IsEnabled() );
+    const double start( monitor ? FitMonitor::GetTime():0 );
+
     // number of fitted points
     int nFitPoints = 0;
 
@@ -28,9 +38,7 @@ int flag )
     // function used for the fit
     TF1* function = (TF1*)virtualFitter->GetUserFunc();
 
-    // store arguments and number of parameters
-    double x[3];
-    function->InitArgs(x,u);
+    // store number of parameters
     npar = function->GetNpar();
 
     // initialization (copied from root)
@@ -41,8 +49,28 @@ int flag )
 
     }
 
+    // use active bins if available
+    out = ( fBinIndex && fBinIndex->GetHistogram() == histogram ) ?
+        Chisquare( *fBinIndex, function, u, nFitPoints ):
+        Chisquare( histogram, function, u, nFitPoints );
+    function->SetNumberFitPoints( nFitPoints );
+
+    if( monitor ) FitMonitor::AddFcnCall( FitMonitor::GetTime() - start );
+    return;
+
+}
+
+//_______________________________________________________________________________
+double ChisquareFitter::Chisquare( TH1* histogram, TF1* function, double* u, int& nFitPoints )
+{
+
+    // store arguments
+    double x[3];
+    function->InitArgs(x,u);
+
     // initialize output
-    out = 0;
+    Reduction::Accumulator out;
+    nFitPoints = 0;
 
     // loop over all bins
     for( int binX = histogram->GetXaxis()->GetFirst(); binX <= histogram->GetXaxis()->GetLast(); ++binX )
@@ -68,12 +96,42 @@ int flag )
 
         // increment fit points and chisquare
         nFitPoints++;
-        out += ROOT_MACRO::SQUARE( (measured-predicted)/error );
+        out.Add( ROOT_MACRO::SQUARE( (measured-predicted)/error ) );
 
     }
 
-    function->SetNumberFitPoints( nFitPoints );
-    return;
+    return out.Get();
+
+}
+
+//_______________________________________________________________________________
+double ChisquareFitter::Chisquare( const BinIndex& index, TF1* function, double* u, int& nFitPoints )
+{
+
+    // store arguments
+    double x[3];
+    function->InitArgs(x,u);
+
+    // initialize output
+    Reduction::Accumulator out;
+    nFitPoints = 0;
+
+    // loop over active bins
+    for( const auto& entry:index.GetEntries() )
+    {
+
+        // evaluate prediction
+        TF1::RejectPoint(false);
+        const double predicted( TMath::Max( function->EvalPar( entry.fX, u ), 1e-9 ) );
+        if( TF1::RejectedPoint() ) continue;
+
+        // increment fit points and chisquare
+        nFitPoints++;
+        out.Add( ROOT_MACRO::SQUARE( (entry.fContent-predicted)/entry.fError ) );
+
+    }
+
+    return out.Get();
 
 }
 
@@ -82,7 +140,7 @@ double ChisquareFitter::Chisquare( TH1* histogram, TF1* function )
 {
 
     double x[3];
-    double out = 0;
+    Reduction::Accumulator out;
 
     // loop over all bins
     for( int binX = histogram->GetXaxis()->GetFirst(); binX <= histogram->GetXaxis()->GetLast(); ++binX )
@@ -107,10 +165,10 @@ double ChisquareFitter::Chisquare( TH1* histogram, TF1* function )
         if( error <= 0 ) continue;
 
         // increment chisquare
-        out += ROOT_MACRO::SQUARE( (measured-predicted)/error );
+        out.Add( ROOT_MACRO::SQUARE( (measured-predicted)/error ) );
 
     }
 
-    return out;
+    return out.Get();
 
 }
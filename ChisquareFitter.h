@@ -4,6 +4,8 @@
 #include <TH1.h>
 #include <TF1.h>
 
+class BinIndex;
+
 //! chisquare fitter
 class ChisquareFitter
 {
@@ -21,6 +23,22 @@ class ChisquareFitter
     /// chisquare
     static double Chisquare( TH1*, TF1* );
 
+    /// chisquare for a given set of parameters. Also returns the number of fitted points
+    static double Chisquare( TH1*, TF1*, double* u, int& nFitPoints );
+
+    /// chisquare over active bins for a given set of parameters. Also returns the number of fitted points
+    /// Points are rejected using the global TF1::RejectPoint flag: concurrent calls require functions that never reject points
+    static double Chisquare( const BinIndex&, TF1*, double* u, int& nFitPoints );
+
+    /// active bins used by Fcn, if built from the fitted histogram
+    static void SetBinIndex( const BinIndex* index )
+    { fBinIndex = index; }
+
+    private:
+
+    /// active bins
+    static const BinIndex* fBinIndex;
+
 };
 
 #endif
@@ -0,0 +1,674 @@
+#include "CsvTable.h"
+#include "Table.h"
+#include "Tokenizer.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <strings.h>
+
+/*!
+  \file CsvTable.cxx
+  \brief csv and tsv import and export of tables
+*/
+
+namespace
+{
+
+  //* size of blocks read from file
+  const size_t blockSize = 1<<22;
+
+  //* buffer size above which output is written to file
+  const size_t flushSize = 1<<20;
+
+  //* quote character
+  const char quote = '"';
+
+  //* field, as a range in the read buffer
+  class Field
+  {
+    public:
+
+    //* constructor
+    Field( char* begin = 0, char* end = 0, bool quoted = false ):
+      fBegin( begin ),
+      fEnd( end ),
+      fQuoted( quoted )
+    {}
+
+    //* begin
+    char* fBegin;
+
+    //* end
+    char* fEnd;
+
+    //* true if field was enclosed in quotes
+    bool fQuoted;
+
+  };
+
+  //* read records from file, by blocks
+  class RecordReader
+  {
+
+    public:
+
+    //* constructor
+    RecordReader( const char* filename, char separator ):
+      fFile( fopen( filename, "rb" ) ),
+      fSeparator( separator ),
+      fBuffer( blockSize ),
+      fBegin( 0 ),
+      fEnd( 0 ),
+      fEof( false )
+    {}
+
+    //* destructor
+    ~RecordReader( void )
+    { if( fFile ) fclose( fFile ); }
+
+    //* true if file could be opened
+    bool IsValid( void ) const
+    { return fFile; }
+
+    //* next non empty record. Fields are valid until the next call. Returns false at end of file
+    bool Next( std::vector<Field>& fields )
+    {
+      for( ;; )
+      {
+        if( Split( fields ) )
+        {
+          // skip empty lines
+          if( fields.size() == 1 && fields[0].fBegin == fields[0].fEnd && !fields[0].fQuoted ) continue;
+
+          for( auto& field:fields )
+          { if( field.fQuoted ) Unescape( field ); }
+
+          return true;
+        }
+
+        if( fEof ) return false;
+        Fill();
+      }
+    }
+
+    private:
+
+    //* split record at buffer start. Returns false if the buffer is empty or the record is incomplete
+    bool Split( std::vector<Field>& fields );
+
+    //* replace doubled quotes by single quotes, in place
+    void Unescape( Field& field ) const
+    {
+      if( !memchr( field.fBegin, quote, field.fEnd - field.fBegin ) ) return;
+      char* out = field.fBegin;
+      for( const char* in = field.fBegin; in < field.fEnd; ++in )
+      {
+        *out++ = *in;
+        if( *in == quote ) ++in;
+      }
+      field.fEnd = out;
+    }
+
+    //* move unparsed data to buffer start and read next block
+    void Fill( void );
+
+    //* file
+    FILE* fFile;
+
+    //* separator
+    char fSeparator;
+
+    //* buffer
+    std::vector<char> fBuffer;
+
+    //* first unparsed character in buffer
+    size_t fBegin;
+
+    //* end of valid data in buffer
+    size_t fEnd;
+
+    //* true once the whole file has been read
+    bool fEof;
+
+  };
+
+  //__________________________________________________________________
+  bool RecordReader::Split( std::vector<Field>& fields )
+  {
+
+    fields.clear();
+    char* data = fBuffer.data();
+    char* p = data + fBegin;
+    char* end = data + fEnd;
+    if( p == end ) return false;
+
+    for( ;; )
+    {
+
+      Field field;
+      if( p < end && *p == quote )
+      {
+
+        // quoted field, up to a quote that is not followed by another quote
+        char* q = p+1;
+        for( ;; )
+        {
+          q = static_cast<char*>( memchr( q, quote, end - q ) );
+          if( !q || q+1 == end )
+          {
+            if( !fEof ) return false;
+            if( !q )
+            {
+              std::cout << "CsvTable::Read - unterminated quoted field" << std::endl;
+              q = end;
+            }
+            break;
+          }
+
+          if( q[1] != quote ) break;
+          q += 2;
+        }
+
+        field = Field( p+1, q, true );
+
+        // characters between closing quote and separator are ignored
+        p = q < end ? q+1:end;
+        while( p < end && *p != fSeparator && *p != '\n' ) ++p;
+
+      } else {
+
+        char* q = p;
+        while( q < end && *q != fSeparator && *q != '\n' ) ++q;
+        field = Field( p, q, false );
+        p = q;
+
+        // remove carriage return at end of record
+        if( field.fEnd > field.fBegin && field.fEnd[-1] == '\r' && ( p == end || *p == '\n' ) ) --field.fEnd;
+
+      }
+
+      if( p == end && !fEof ) return false;
+      fields.push_back( field );
+
+      if( p == end )
+      {
+        fBegin = fEnd;
+        return true;
+      }
+
+      if( *p == '\n' )
+      {
+        fBegin = p+1 - data;
+        return true;
+      }
+
+      // separator
+      ++p;
+
+    }
+
+  }
+
+  //__________________________________________________________________
+  void RecordReader::Fill( void )
+  {
+
+    // move unparsed data to buffer start. The buffer grows if a single record fills it
+    const size_t remaining = fEnd - fBegin;
+    if( fBegin ) memmove( fBuffer.data(), fBuffer.data() + fBegin, remaining );
+    fBegin = 0;
+    fEnd = remaining;
+    if( fEnd == fBuffer.size() ) fBuffer.resize( 2*fBuffer.size() );
+
+    const size_t size = fread( fBuffer.data() + fEnd, 1, fBuffer.size() - fEnd, fFile );
+    fEnd += size;
+    if( !size ) fEof = true;
+
+  }
+
+  //__________________________________________________________________
+  //* true if field is null
+  bool IsNull( const Field& field, const std::vector<std::string>& nullValues )
+  {
+    const size_t size = field.fEnd - field.fBegin;
+    if( !size ) return true;
+    for( const auto& value:nullValues )
+    { if( value.size() == size && !memcmp( value.data(), field.fBegin, size ) ) return true; }
+    return false;
+  }
+
+  //__________________________________________________________________
+  //* parse number, ignoring surrounding spaces. Returns false unless the whole field is a number
+  template<typename T> bool ParseNumber( const Field& field, T& value )
+  {
+    const char* begin = field.fBegin;
+    const char* end = field.fEnd;
+    while( begin < end && *begin == ' ' ) ++begin;
+    while( end > begin && end[-1] == ' ' ) --end;
+    return Tokenizer::ParseExact( begin, end, value );
+  }
+
+  //__________________________________________________________________
+  //* parse boolean. Returns false unless field is true or false
+  bool ParseBool( const Field& field, bool& value )
+  {
+    const size_t size = field.fEnd - field.fBegin;
+    if( size == 4 && !strncasecmp( field.fBegin, "true", 4 ) ) value = true;
+    else if( size == 5 && !strncasecmp( field.fBegin, "false", 5 ) ) value = false;
+    else return false;
+    return true;
+  }
+
+  //* column type inferred from sampled values
+  class Inference
+  {
+    public:
+
+    //* constructor
+    Inference( void ):
+      fBool( true ),
+      fInt( true ),
+      fDouble( true ),
+      fNull( false )
+    {}
+
+    //* add sampled value
+    void Add( const Field& field, bool isNull )
+    {
+      if( isNull )
+      {
+        fNull = true;
+        return;
+      }
+
+      bool boolValue;
+      int intValue;
+      double doubleValue;
+      fBool &= ParseBool( field, boolValue );
+      fInt &= ParseNumber( field, intValue );
+      fDouble &= ParseNumber( field, doubleValue );
+    }
+
+    //* type. Null values can only be represented in double columns
+    CsvTable::Type Get( void ) const
+    {
+      if( fBool && !fNull ) return CsvTable::Bool;
+      else if( fInt && !fNull ) return CsvTable::Int;
+      else if( fDouble ) return CsvTable::Double;
+      else return CsvTable::String;
+    }
+
+    private:
+
+    //* true while all values are booleans
+    bool fBool;
+
+    //* true while all values are integers
+    bool fInt;
+
+    //* true while all values are numbers
+    bool fDouble;
+
+    //* true if a null value was found
+    bool fNull;
+
+  };
+
+  //__________________________________________________________________
+  //* new column of given type
+  ColumnBase* NewColumn( CsvTable::Type type, const std::string& name )
+  {
+    ColumnBase* out = 0;
+    switch( type )
+    {
+      case CsvTable::Double: out = new ColumnDouble(); break;
+      case CsvTable::Float: out = new ColumnFloat(); break;
+      case CsvTable::Int: out = new ColumnInt(); break;
+      case CsvTable::Bool: out = new ColumnBool(); break;
+      default: out = new ColumnString(); break;
+    }
+
+    out->SetName( name.c_str() );
+    return out;
+  }
+
+  //* columns being read
+  class ColumnReader
+  {
+    public:
+
+    //* constructor
+    ColumnReader( ColumnBase* column, CsvTable::Type type ):
+      fColumn( column ),
+      fType( type ),
+      fNInvalid( 0 )
+    {}
+
+    //* append field value
+    void Append( const Field& field, bool isNull )
+    {
+      switch( fType )
+      {
+        case CsvTable::Double:
+        {
+          double value = std::numeric_limits<double>::quiet_NaN();
+          if( !isNull && !ParseNumber( field, value ) )
+          {
+            value = std::numeric_limits<double>::quiet_NaN();
+            ++fNInvalid;
+          }
+          static_cast<ColumnDouble*>( fColumn )->Append( value );
+          break;
+        }
+
+        case CsvTable::Float:
+        {
+          float value = std::numeric_limits<float>::quiet_NaN();
+          if( !isNull && !ParseNumber( field, value ) )
+          {
+            value = std::numeric_limits<float>::quiet_NaN();
+            ++fNInvalid;
+          }
+          static_cast<ColumnFloat*>( fColumn )->Append( value );
+          break;
+        }
+
+        case CsvTable::Int:
+        {
+          int value = 0;
+          if( isNull || !ParseNumber( field, value ) )
+          {
+            value = 0;
+            ++fNInvalid;
+          }
+          static_cast<ColumnInt*>( fColumn )->Append( value );
+          break;
+        }
+
+        case CsvTable::Bool:
+        {
+          bool value = false;
+          if( isNull || !ParseBool( field, value ) )
+          {
+            value = false;
+            ++fNInvalid;
+          }
+          static_cast<ColumnBool*>( fColumn )->Append( value );
+          break;
+        }
+
+        default:
+        static_cast<ColumnString*>( fColumn )->Append( TString( field.fBegin, field.fEnd - field.fBegin ) );
+        break;
+      }
+    }
+
+    //* column
+    ColumnBase* fColumn;
+
+    //* type
+    CsvTable::Type fType;
+
+    //* number of values that could not be converted
+    int fNInvalid;
+
+  };
+
+  //__________________________________________________________________
+  //* append string field, quoted if needed
+  void AppendString( std::string& buffer, const char* value, size_t size, char separator )
+  {
+    bool quoted = false;
+    for( size_t i = 0; i < size && !quoted; ++i )
+    {
+      const char c = value[i];
+      quoted = ( c == separator || c == quote || c == '\n' || c == '\r' );
+    }
+
+    if( !quoted )
+    {
+      buffer.append( value, size );
+      return;
+    }
+
+    buffer += quote;
+    for( size_t i = 0; i < size; ++i )
+    {
+      if( value[i] == quote ) buffer += quote;
+      buffer += value[i];
+    }
+    buffer += quote;
+  }
+
+  //__________________________________________________________________
+  //* append number, with shortest round trip representation. NaN is written as an empty field
+  template<typename T> void AppendNumber( std::string& buffer, T value )
+  {
+    if( value != value ) return;
+    char text[64];
+    const std::to_chars_result result = std::to_chars( text, text + sizeof( text ), value );
+    buffer.append( text, result.ptr - text );
+  }
+
+  //__________________________________________________________________
+  //* end record started at begin. A record with a single empty field is written as an empty quoted string, since empty lines are skipped on input
+  void EndRecord( std::string& buffer, size_t begin )
+  {
+    if( buffer.size() == begin ) buffer.append( 2, quote );
+    buffer += '\n';
+  }
+
+  //* column being written
+  class ColumnWriter
+  {
+    public:
+
+    //* constructor
+    ColumnWriter( const ColumnBase* column ):
+      fColumn( column ),
+      fType( CsvTable::Auto ),
+      fValues( 0 )
+    {
+      if( const ColumnDouble* typed = dynamic_cast<const ColumnDouble*>( column ) ) { fType = CsvTable::Double; fValues = typed->GetValues().data(); }
+      else if( const ColumnFloat* typed = dynamic_cast<const ColumnFloat*>( column ) ) { fType = CsvTable::Float; fValues = typed->GetValues().data(); }
+      else if( const ColumnInt* typed = dynamic_cast<const ColumnInt*>( column ) ) { fType = CsvTable::Int; fValues = typed->GetValues().data(); }
+      else if( const ColumnBool* typed = dynamic_cast<const ColumnBool*>( column ) ) { fType = CsvTable::Bool; fValues = typed->GetValues().data(); }
+      else if( const ColumnString* typed = dynamic_cast<const ColumnString*>( column ) ) { fType = CsvTable::String; fValues = typed->GetValues().data(); }
+    }
+
+    //* append value at given line
+    void Append( std::string& buffer, int line, char separator ) const
+    {
+      switch( fType )
+      {
+        case CsvTable::Double: AppendNumber( buffer, static_cast<const double*>( fValues )[line] ); break;
+        case CsvTable::Float: AppendNumber( buffer, static_cast<const float*>( fValues )[line] ); break;
+        case CsvTable::Int: AppendNumber( buffer, static_cast<const int*>( fValues )[line] ); break;
+        case CsvTable::Bool: buffer.append( static_cast<const unsigned char*>( fValues )[line] ? "true":"false" ); break;
+
+        case CsvTable::String:
+        {
+          const TString& value( static_cast<const TString*>( fValues )[line] );
+          AppendString( buffer, value.Data(), value.Length(), separator );
+          break;
+        }
+
+        default:
+        {
+          const TString value( fColumn->GetString( line ) );
+          AppendString( buffer, value.Data(), value.Length(), separator );
+          break;
+        }
+      }
+    }
+
+    private:
+
+    //* column
+    const ColumnBase* fColumn;
+
+    //* type, Auto for other columns
+    CsvTable::Type fType;
+
+    //* values
+    const void* fValues;
+
+  };
+
+}
+
+//__________________________________________________________________
+bool CsvTable::Read( Table& table, const char* filename, const Options& options )
+{
+
+  RecordReader reader( filename, options.fSeparator );
+  if( !reader.IsValid() )
+  {
+    std::cout << "CsvTable::Read - cannot open file " << filename << std::endl;
+    return false;
+  }
+
+  // column names
+  std::vector<Field> fields;
+  std::vector<std::string> names;
+  if( options.fHeader )
+  {
+    if( !reader.Next( fields ) )
+    {
+      std::cout << "CsvTable::Read - empty file " << filename << std::endl;
+      return false;
+    }
+
+    for( const auto& field:fields )
+    { names.push_back( std::string( field.fBegin, field.fEnd ) ); }
+  }
+
+  // sampled records are copied, since the read buffer is reused
+  std::vector< std::vector<std::string> > sample;
+  while( int( sample.size() ) < options.fSampleLines && reader.Next( fields ) )
+  {
+    sample.push_back( std::vector<std::string>() );
+    for( const auto& field:fields )
+    { sample.back().push_back( std::string( field.fBegin, field.fEnd ) ); }
+  }
+
+  const int nColumns = options.fHeader ? names.size():( sample.empty() ? 0:sample.front().size() );
+  names.resize( nColumns );
+  if( !nColumns )
+  {
+    std::cout << "CsvTable::Read - no columns found in " << filename << std::endl;
+    return false;
+  }
+
+  // sampled records, as fields
+  std::vector< std::vector<Field> > sampleFields( sample.size() );
+  for( size_t row = 0; row < sample.size(); ++row )
+    for( auto& value:sample[row] )
+  { sampleFields[row].push_back( Field( &value[0], &value[0] + value.size() ) ); }
+
+  // column types
+  std::vector<ColumnReader> columns;
+  for( int i = 0; i < nColumns; ++i )
+  {
+    Type type = i < int( options.fSchema.size() ) ? options.fSchema[i]:Auto;
+    if( type == Auto )
+    {
+      Inference inference;
+      for( const auto& record:sampleFields )
+      {
+        if( i < int( record.size() ) ) inference.Add( record[i], IsNull( record[i], options.fNullValues ) );
+        else inference.Add( Field(), true );
+      }
+      type = inference.Get();
+    }
+
+    columns.push_back( ColumnReader( NewColumn( type, names[i] ), type ) );
+  }
+
+  // values. Missing fields are null
+  int nLines = 0;
+  auto append = [&]( const std::vector<Field>& record )
+  {
+    for( int i = 0; i < nColumns; ++i )
+    {
+      if( i < int( record.size() ) ) columns[i].Append( record[i], IsNull( record[i], options.fNullValues ) );
+      else columns[i].Append( Field(), true );
+    }
+    ++nLines;
+  };
+
+  for( const auto& record:sampleFields ) append( record );
+  while( reader.Next( fields ) ) append( fields );
+
+  for( int i = 0; i < nColumns; ++i )
+  {
+    if( columns[i].fNInvalid ) std::cout << "CsvTable::Read - column " << i << ": " << columns[i].fNInvalid << " invalid values" << std::endl;
+    table.AddColumn( columns[i].fColumn );
+  }
+
+  std::cout << "CsvTable::Read - " << nLines << " lines read" << std::endl;
+  std::cout << "CsvTable::Read - number of columns: " << nColumns << std::endl;
+  return true;
+
+}
+
+//__________________________________________________________________
+bool CsvTable::Write( const Table& table, const char* filename, const Options& options )
+{
+
+  std::ofstream out( filename, std::ios::binary );
+  if( !out )
+  {
+    std::cout << "CsvTable::Write - cannot open file " << filename << std::endl;
+    return false;
+  }
+
+  const int nColumns = table.GetNColumns();
+  const int nLines = nColumns ? table.GetNLines():0;
+  std::string buffer;
+  buffer.reserve( flushSize + ( flushSize>>4 ) );
+
+  // header
+  if( options.fHeader )
+  {
+    const size_t begin = buffer.size();
+    for( int i = 0; i < nColumns; ++i )
+    {
+      if( i ) buffer += options.fSeparator;
+      const TString& name( table.GetColumn( i )->GetName() );
+      AppendString( buffer, name.Data(), name.Length(), options.fSeparator );
+    }
+    EndRecord( buffer, begin );
+  }
+
+  // records
+  std::vector<ColumnWriter> columns;
+  for( int i = 0; i < nColumns; ++i )
+  { columns.push_back( ColumnWriter( table.GetColumn( i ) ) ); }
+
+  for( int line = 0; line < nLines; ++line )
+  {
+    const size_t begin = buffer.size();
+    for( int i = 0; i < nColumns; ++i )
+    {
+      if( i ) buffer += options.fSeparator;
+      columns[i].Append( buffer, line, options.fSeparator );
+    }
+    EndRecord( buffer, begin );
+
+    if( buffer.size() >= flushSize )
+    {
+      out.write( buffer.data(), buffer.size() );
+      buffer.clear();
+    }
+  }
+
+  out.write( buffer.data(), buffer.size() );
+  return bool( out );
+
+}
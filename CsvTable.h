@@ -0,0 +1,90 @@
+#ifndef CsvTable_h
+#define CsvTable_h
+
+/*!
+\file    CsvTable.h
+\brief   csv and tsv import and export of tables
+*/
+
+#include <string>
+#include <vector>
+
+class Table;
+
+/*!
+\class   CsvTable
+\brief   csv and tsv import and export of tables
+
+Files follow RFC 4180: records are separated by LF or CRLF, fields by a separator
+character, and fields holding separators, quotes or line breaks are enclosed in double
+quotes, with embedded quotes doubled. The separator is configurable, for instance a tab
+for tsv files. Empty lines are skipped.
+
+Files are read in fixed size blocks, and records are split in place in the block. Only
+records crossing a block boundary are moved. Column types are inferred from the first
+records, unless given explicitly: columns whose values are all true or false are boolean,
+all integers are int, all numbers are double, and strings otherwise. Null values, empty
+fields or fields matching one of the null values, are read as NaN in double columns. They
+make inferred integer columns double, and inferred boolean columns strings. Records with
+fewer fields than the header are completed with null values. Extra fields are ignored.
+
+On output, records end with LF. Doubles and floats are written with the shortest
+representation that reads back to the same value, NaN as an empty field, and booleans
+as true or false. A record holding a single empty field is written as "", so that it is
+not read back as an empty line.
+*/
+class CsvTable
+{
+
+  public:
+
+  //! column types, for explicit schemas
+  enum Type
+  {
+    Auto,
+    Double,
+    Float,
+    Int,
+    Bool,
+    String
+  };
+
+  //! read and write options
+  class Options
+  {
+    public:
+
+    //! constructor
+    Options( char separator = ',', bool header = true ):
+      fSeparator( separator ),
+      fHeader( header ),
+      fSampleLines( 1000 ),
+      fNullValues( { "NA", "NULL", "null" } )
+    {}
+
+    //! field separator
+    char fSeparator;
+
+    //! true if the first record holds column names
+    bool fHeader;
+
+    //! number of records used to infer column types
+    int fSampleLines;
+
+    //! column types. Columns with no entry, or Auto, are inferred
+    std::vector<Type> fSchema;
+
+    //! field values read as null in numeric columns, in addition to empty fields
+    std::vector<std::string> fNullValues;
+
+  };
+
+  //! add columns read from file to table. Returns false if the file could not be read
+  static bool Read( Table& table, const char* filename, const Options& options = Options() );
+
+  //! write table to file. Returns false if the file could not be written
+  static bool Write( const Table& table, const char* filename, const Options& options = Options() );
+
+};
+
+#endif
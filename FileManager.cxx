@@ -466,8 +466,10 @@ TH1* FileManager::TreeToHisto(
     return nullptr;
   }
 
-  // clone histogram into template
+  // temporary histogram, cloned once and attached to each file while projecting the tree
   TString tmpName( TString(hName)+"_tmp" );
+  std::unique_ptr<TH1> hTmp( Utils::NewClone( tmpName.Data(), tmpName.Data(), h, kTRUE ) );
+  hTmp->SetDirectory( nullptr );
 
   // loop over TFiles
   unsigned int count(0);
@@ -491,10 +493,11 @@ TH1* FileManager::TreeToHisto(
     auto tree = static_cast<TTree*>(f->Get(treename));
     if( tree )
     {
-      // project tree to histogram
-      auto hTmp( Utils::NewClone( tmpName.Data(), tmpName.Data(), h ) );
+      // project tree to histogram. Projection resets the temporary histogram
+      hTmp->SetDirectory( f.get() );
       tree->Project( tmpName, var, cut );
-      h->Add( hTmp );
+      hTmp->SetDirectory( nullptr );
+      h->Add( hTmp.get() );
     } else {
       std::cout << "FileManager::TreeToHisto - Unable to load chain \"" << treename << "\"." << std::endl;
     }
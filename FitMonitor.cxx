@@ -0,0 +1,261 @@
+#include "FitMonitor.h"
+#include "Table.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+/*!
+  \file FitMonitor.cxx
+  \brief performance records for fits performed with FitUtils::Fit
+*/
+
+namespace
+{
+
+  //* stored records, protected by mutex
+  std::mutex gMutex;
+  std::vector<FitMonitor::Record> gRecords;
+
+  //* record being filled in current thread
+  thread_local FitMonitor::Record gCurrent;
+
+  //* start time of record being filled in current thread
+  thread_local double gStart = 0;
+
+  //* true if a record is being filled in current thread
+  thread_local bool gActive = false;
+
+  //* totals over records
+  class Totals
+  {
+    public:
+
+    //* constructor
+    Totals( const std::vector<FitMonitor::Record>& records ):
+      fWallTime( 0 ),
+      fFcnTime( 0 ),
+      fNCalls( 0 ),
+      fNFailed( 0 )
+    {
+      for( const auto& record:records )
+      {
+        fWallTime += record.fWallTime;
+        fFcnTime += record.fFcnTime;
+        fNCalls += record.fNCalls;
+        if( record.fStatus ) ++fNFailed;
+      }
+    }
+
+    double fWallTime;
+    double fFcnTime;
+    long fNCalls;
+    int fNFailed;
+  };
+
+  //* escape string for json output
+  TString Escape( const TString& in )
+  {
+    TString out;
+    for( int i = 0; i < in.Length(); ++i )
+    {
+      const char c = in[i];
+      if( c == '"' || c == '\\' ) { out += '\\'; out += c; }
+      else if( static_cast<unsigned char>( c ) < 0x20 ) out += Form( "\\u%04x", static_cast<unsigned int>( static_cast<unsigned char>( c ) ) );
+      else out += c;
+    }
+    return out;
+  }
+
+  //* number for json output, which has no nan nor infinity
+  std::string Number( double value )
+  {
+    if( !std::isfinite( value ) ) return "null";
+    std::ostringstream out;
+    out << value;
+    return out.str();
+  }
+
+}
+
+//__________________________________
+bool FitMonitor::fEnabled = false;
+
+//__________________________________________________________________
+void FitMonitor::Clear( void )
+{
+  std::lock_guard<std::mutex> lock( gMutex );
+  gRecords.clear();
+}
+
+//__________________________________________________________________
+std::vector<FitMonitor::Record> FitMonitor::GetRecords( void )
+{
+  std::lock_guard<std::mutex> lock( gMutex );
+  return gRecords;
+}
+
+//__________________________________________________________________
+double FitMonitor::GetTime( void )
+{ return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count(); }
+
+//__________________________________________________________________
+void FitMonitor::Start( const TString& name, const TString& fitter )
+{
+  gCurrent = Record();
+  gCurrent.fName = name;
+  gCurrent.fFitter = fitter;
+  gActive = true;
+  gStart = GetTime();
+}
+
+//__________________________________________________________________
+void FitMonitor::AddFcnCall( double time )
+{
+  if( !gActive ) return;
+  ++gCurrent.fNCalls;
+  gCurrent.fFcnTime += time;
+}
+
+//__________________________________________________________________
+void FitMonitor::Stop( int status, int nCalls, int nBins )
+{
+
+  if( !gActive ) return;
+  gActive = false;
+
+  gCurrent.fWallTime = GetTime() - gStart;
+  gCurrent.fStatus = status;
+  gCurrent.fNBins = nBins;
+  if( nCalls >= 0 ) gCurrent.fNCalls = nCalls;
+
+  std::lock_guard<std::mutex> lock( gMutex );
+  gRecords.push_back( gCurrent );
+
+}
+
+//__________________________________________________________________
+Table* FitMonitor::GetTable( void )
+{
+
+  const std::vector<Record> records( GetRecords() );
+  const int nLines = records.size();
+
+  std::vector<const char*> names;
+  std::vector<const char*> fitters;
+  for( const auto& record:records )
+  {
+    names.push_back( record.fName.Data() );
+    fitters.push_back( record.fFitter.Data() );
+  }
+
+  Table* table = new Table();
+  table->AddStringColumn( "name", names.data(), nLines, "%s" );
+  table->AddStringColumn( "fitter", fitters.data(), nLines, "%s" );
+
+  std::vector<double> values( nLines );
+  for( int i = 0; i < nLines; ++i ) values[i] = records[i].fNCalls;
+  table->AddColumn( "calls", values.data(), nLines, "%.0f" );
+
+  for( int i = 0; i < nLines; ++i ) values[i] = records[i].fNBins;
+  table->AddColumn( "bins", values.data(), nLines, "%.0f" );
+
+  for( int i = 0; i < nLines; ++i ) values[i] = 1e3*records[i].fFcnTime;
+  table->AddColumn( "fcn (ms)", values.data(), nLines, "%.3g" );
+
+  for( int i = 0; i < nLines; ++i ) values[i] = 1e9*records[i].GetTimePerBin();
+  table->AddColumn( "bin (ns)", values.data(), nLines, "%.3g" );
+
+  for( int i = 0; i < nLines; ++i ) values[i] = 1e3*records[i].fWallTime;
+  table->AddColumn( "wall (ms)", values.data(), nLines, "%.3g" );
+
+  for( int i = 0; i < nLines; ++i ) values[i] = records[i].fStatus;
+  table->AddColumn( "status", values.data(), nLines, "%.0f" );
+
+  return table;
+
+}
+
+//__________________________________________________________________
+void FitMonitor::PrintSummary( std::ostream& out, int nSlowest )
+{
+
+  std::vector<Record> records( GetRecords() );
+
+  const Totals totals( records );
+
+  out << "FitMonitor::PrintSummary - fits: " << records.size() << " failed: " << totals.fNFailed << std::endl;
+  out << "FitMonitor::PrintSummary - wall time: " << totals.fWallTime << " s fcn time: " << totals.fFcnTime << " s fcn calls: " << totals.fNCalls << std::endl;
+
+  // slowest fits first
+  std::stable_sort( records.begin(), records.end(),
+    []( const Record& first, const Record& second ) { return first.fWallTime > second.fWallTime; } );
+
+  const int n = std::min<int>( nSlowest, records.size() );
+  for( int i = 0; i < n; ++i )
+  {
+    const Record& record( records[i] );
+    out << "FitMonitor::PrintSummary - " << record.fName << " (" << record.fFitter << ")"
+      << " wall: " << 1e3*record.fWallTime << " ms"
+      << " calls: " << record.fNCalls
+      << " bins: " << record.fNBins
+      << " status: " << record.fStatus
+      << std::endl;
+  }
+
+}
+
+//__________________________________________________________________
+void FitMonitor::PrintJSON( std::ostream& out )
+{
+
+  const std::vector<Record> records( GetRecords() );
+
+  const Totals totals( records );
+
+  out << "{" << std::endl;
+  out << "  \"summary\": {"
+    << " \"fits\": " << records.size()
+    << ", \"failed\": " << totals.fNFailed
+    << ", \"calls\": " << totals.fNCalls
+    << ", \"fcn_time\": " << Number( totals.fFcnTime )
+    << ", \"wall_time\": " << Number( totals.fWallTime )
+    << " }," << std::endl;
+
+  out << "  \"fits\": [" << std::endl;
+  for( unsigned int i = 0; i < records.size(); ++i )
+  {
+    const Record& record( records[i] );
+    out << "    {"
+      << " \"name\": \"" << Escape( record.fName ) << "\""
+      << ", \"fitter\": \"" << Escape( record.fFitter ) << "\""
+      << ", \"calls\": " << record.fNCalls
+      << ", \"bins\": " << record.fNBins
+      << ", \"fcn_time\": " << Number( record.fFcnTime )
+      << ", \"time_per_bin\": " << Number( record.GetTimePerBin() )
+      << ", \"wall_time\": " << Number( record.fWallTime )
+      << ", \"status\": " << record.fStatus
+      << " }" << ( i+1 < records.size() ? ",":"" ) << std::endl;
+  }
+  out << "  ]" << std::endl;
+  out << "}" << std::endl;
+
+}
+
+//__________________________________________________________________
+void FitMonitor::WriteJSON( const char* filename )
+{
+
+  std::ofstream out( filename );
+  if( !out.good() )
+  {
+    std::cout << "FitMonitor::WriteJSON - cannot write to " << filename << std::endl;
+    return;
+  }
+
+  PrintJSON( out );
+
+}
@@ -0,0 +1,132 @@
+#ifndef FitMonitor_h
+#define FitMonitor_h
+
+/*!
+\file    FitMonitor.h
+\brief   performance records for fits performed with FitUtils::Fit
+*/
+
+#include <TROOT.h>
+#include <TObject.h>
+#include <TString.h>
+
+#include <iostream>
+#include <vector>
+
+class Table;
+
+/*!
+\class   FitMonitor
+\brief   performance records for fits performed with FitUtils::Fit
+
+When enabled, each call to FitUtils::Fit stores one record with the number of
+fcn calls, the total time spent in fcn, the number of fitted bins, the total wall
+time and the fit status. Fcn time is only measured for local fitters (option "U")
+and n-dimensional histogram fits. For the default ROOT fitters the number of calls
+is taken from the fit result: option "S" is added internally, but FitUtils::Fit
+still only returns the fit status unless "S" was requested by the caller.
+
+Recording is thread safe, so that fits performed from BatchFitter and ToyFitter
+workers can be monitored as well.
+*/
+class FitMonitor
+{
+
+  public:
+
+  //! performance record for one fit
+  class Record
+  {
+    public:
+
+    //! constructor
+    Record( void ):
+      fNCalls( 0 ),
+      fFcnTime( 0 ),
+      fNBins( 0 ),
+      fWallTime( 0 ),
+      fStatus( 0 )
+    {}
+
+    //! average fcn time per call and per bin
+    double GetTimePerBin( void ) const
+    { return ( fNCalls > 0 && fNBins > 0 ) ? fFcnTime/( double( fNCalls )*fNBins ):0; }
+
+    //! histogram and function names
+    TString fName;
+
+    //! fitter
+    TString fFitter;
+
+    //! number of fcn calls
+    int fNCalls;
+
+    //! total time spent in fcn (s)
+    double fFcnTime;
+
+    //! number of fitted bins
+    int fNBins;
+
+    //! total wall time (s)
+    double fWallTime;
+
+    //! fit status
+    int fStatus;
+  };
+
+  //! enable recording
+  static void SetEnabled( bool value )
+  { fEnabled = value; }
+
+  //! true if recording is enabled
+  static bool IsEnabled( void )
+  { return fEnabled; }
+
+  //! clear records
+  static void Clear( void );
+
+  //! records
+  static std::vector<Record> GetRecords( void );
+
+  //*@name recording, used by fitters
+  //@{
+
+  //! monotonic time (s)
+  static double GetTime( void );
+
+  //! start recording a fit in current thread
+  static void Start( const TString& name, const TString& fitter );
+
+  //! add fcn call in current thread
+  static void AddFcnCall( double time );
+
+  //! stop recording fit in current thread. Negative number of calls means counted calls are used
+  static void Stop( int status, int nCalls, int nBins );
+
+  //@}
+
+  //*@name output
+  //@{
+
+  //! one line per fit
+  static Table* GetTable( void );
+
+  //! summary and slowest fits
+  static void PrintSummary( std::ostream& out = std::cout, int nSlowest = 10 );
+
+  //! json dump
+  static void PrintJSON( std::ostream& out = std::cout );
+
+  //! json dump to file
+  static void WriteJSON( const char* filename );
+
+  //@}
+
+  private:
+
+  //! true if enabled
+  static bool fEnabled;
+
+};
+
+#endif
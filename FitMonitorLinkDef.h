@@ -0,0 +1,6 @@
+#ifdef __CINT__
+
+#pragma link C++ class FitMonitor;
+#pragma link C++ class FitMonitor::Record;
+
+#endif
@@ -3,67 +3,336 @@
 #include "FitUtils.h"
 
 #include "ROOT_MACRO.h"
+#include "BinIndex.h"
 #include "ChisquareFitter.h"
+#include "FitMonitor.h"
 #include "LikelihoodFitter.h"
 
 #include <TROOT.h>
 #include <TMath.h>
+#include <TMinuit.h>
 #include <TF1.h>
+#include <TFitResult.h>
+#include <THnBase.h>
 #include <TVirtualFitter.h>
+#include <Math/MinimizerOptions.h>
+
+#include <algorithm>
 #include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
 
 using namespace UTILS;
 
+namespace
+{
+
+  //____________________________________________
+  //* crystal ball tail, a/(b-t)^n, with a stored as log(a)
+  class CrystalBallTail
+  {
+    public:
+
+    //* default constructor
+    CrystalBallTail( void ):
+      fAlpha( 0 ),
+      fN( 0 ),
+      fLogA( 0 ),
+      fB( 0 )
+    {}
+
+    //* constructor
+    CrystalBallTail( double alpha, double n ):
+      fAlpha( fabs( alpha ) ),
+      fN( n ),
+      fLogA( n*std::log( n/fAlpha ) - ROOT_MACRO::SQUARE( fAlpha )/2 ),
+      fB( n/fAlpha - fAlpha )
+    {}
+
+    //* evaluate for t < -alpha
+    double Eval( double t ) const
+    { return std::exp( fLogA - fN*std::log( fB - t ) ); }
+
+    double fAlpha;
+    double fN;
+    double fLogA;
+    double fB;
+  };
+
+  //____________________________________________
+  //* crystal ball tail, recalculated only when parameters change
+  class CrystalBallTailCache
+  {
+    public:
+
+    //* constructor
+    CrystalBallTailCache( void ):
+      fAlpha( std::numeric_limits<double>::quiet_NaN() ),
+      fN( std::numeric_limits<double>::quiet_NaN() )
+    {}
+
+    //* tail matching parameters
+    const CrystalBallTail& Get( double alpha, double n )
+    {
+      if( !( alpha == fAlpha && n == fN ) )
+      {
+        fAlpha = alpha;
+        fN = n;
+        fTail = CrystalBallTail( alpha, n );
+      }
+      return fTail;
+    }
+
+    private:
+
+    double fAlpha;
+    double fN;
+    CrystalBallTail fTail;
+  };
+
+  //____________________________________________
+  //* normalization integral, keyed on the N shape parameters it depends on
+  template<int N> class IntegralCache
+  {
+    public:
+
+    //* constructor
+    IntegralCache( void ):
+      fValue( 0 )
+    { std::fill( fKey, fKey+N, std::numeric_limits<double>::quiet_NaN() ); }
+
+    //* true if stored integral corresponds to parameters
+    bool Matches( const double* par ) const
+    { return std::equal( par, par+N, fKey ); }
+
+    //* stored integral
+    double Get( void ) const
+    { return fValue; }
+
+    //* store integral for parameters
+    double Store( const double* par, double value )
+    {
+      std::copy( par, par+N, fKey );
+      return fValue = value;
+    }
+
+    private:
+
+    double fKey[N];
+    double fValue;
+  };
+
+  //____________________________________________
+  //* active bins, function and mode for n-dimensional histogram fits
+  const BinIndex* gBinIndex = 0;
+  TF1* gFunction = 0;
+  bool gLikelihood = false;
+
+  //____________________________________________
+  //* minuit function for n-dimensional histogram fits
+  void BinIndexFcn( int& npar, double* gin, double& out, double* u, int flag )
+  {
+    const bool monitor( FitMonitor::IsEnabled() );
+    const double start( monitor ? FitMonitor::GetTime():0 );
+
+    int nFitPoints = 0;
+    out = gLikelihood ?
+      LikelihoodFitter::LogLikelihood( *gBinIndex, gFunction, u, nFitPoints ):
+      ChisquareFitter::Chisquare( *gBinIndex, gFunction, u, nFitPoints );
+
+    if( monitor ) FitMonitor::AddFcnCall( FitMonitor::GetTime() - start );
+  }
+
+}
+
 //_______________________________________________________________________________
 //* root dictionary
 ClassImp(FitUtils);
 
 //_______________________________________________________________________________
-TFitResultPtr FitUtils::Fit( TH1* h, TF1* f, TString option )
+TFitResultPtr FitUtils::Fit( TH1* h, TF1* f, TString option, const TH1* mask )
 {
 
+  // quiet mode
+  const bool quiet( option.Contains( "Q" ) );
+
+  // local fitter
+  const bool local( option.Contains( "U" ) );
+
+  // active bins, used by local fitters
+  BinIndex index;
+
   // setup virtual fitter
-  if( option.Contains( "U" ) )
+  TString fitter;
+  if( local )
   {
 
     if( option.Contains( "L" ) )
     {
 
-      std::cout << "FitUtils::Fit - using local Likelihood fitter" << std::endl;
+      fitter = "local likelihood";
+      if( !quiet ) std::cout << "FitUtils::Fit - using local Likelihood fitter" << std::endl;
       TVirtualFitter::Fitter(h)->SetFCN( LikelihoodFitter::Fcn );
+      index.Build( h, f, false, mask );
+      LikelihoodFitter::SetBinIndex( &index );
 
     } else {
 
-      std::cout << "FitUtils::Fit - using local chisquare fitter" << std::endl;
+      fitter = "local chisquare";
+      if( !quiet ) std::cout << "FitUtils::Fit - using local chisquare fitter" << std::endl;
       TVirtualFitter::Fitter(h)->SetFCN( ChisquareFitter::Fcn );
+      index.Build( h, f, true, mask );
+      ChisquareFitter::SetBinIndex( &index );
 
     }
 
+    if( !quiet ) std::cout << "FitUtils::Fit - active bins: " << index.GetSize() << std::endl;
+
   } else if( option.Contains( "L" ) ) {
 
-    std::cout << "FitUtils::Fit - using default Likelihood fitter" << std::endl;
+    fitter = "default likelihood";
+    if( !quiet ) std::cout << "FitUtils::Fit - using default Likelihood fitter" << std::endl;
 
   } else {
 
-    std::cout << "FitUtils::Fit - using default chisquare fitter" << std::endl;
+    fitter = "default chisquare";
+    if( !quiet ) std::cout << "FitUtils::Fit - using default chisquare fitter" << std::endl;
+
+  }
+
+  if( mask && !local )
+  { std::cout << "FitUtils::Fit - mask is only used by local fitters. Ignored" << std::endl; }
 
+  // performance monitoring. The fit result is needed to get the number of calls from default fitters
+  const bool monitor( FitMonitor::IsEnabled() );
+  const bool storeResult( monitor && !local && !option.Contains( "S" ) );
+  if( monitor )
+  {
+    FitMonitor::Start( Form( "%s/%s", h->GetName(), f->GetName() ), fitter );
+    if( storeResult ) option += "S";
   }
 
   // fit
   TFitResultPtr result =  h->Fit( f, option );
 
-  if( option.Contains( "U" ) )
+  if( local )
   {
 
-    std::cout << "FitUtils::Fit - calculating chisquare manually" << std::endl;
+    LikelihoodFitter::SetBinIndex( 0 );
+    ChisquareFitter::SetBinIndex( 0 );
+
+    if( !quiet ) std::cout << "FitUtils::Fit - calculating chisquare manually" << std::endl;
     f->SetChisquare( ChisquareFitter::Chisquare( h, f ) );
 
   }
 
+  if( monitor )
+  {
+    if( local ) FitMonitor::Stop( int( result ), -1, index.GetSize() );
+    else FitMonitor::Stop( int( result ), result.Get() ? result->NCalls():0, f->GetNumberFitPoints() );
+  }
+
+  // only return the status if the fit result was not requested, as without monitoring
+  if( storeResult ) return TFitResultPtr( int( result ) );
   return result;
 
 }
 
+//_______________________________________________________________________________
+bool FitUtils::IsThreadSafe( const TString& option )
+{ return !option.Contains( "U" ) && ROOT::Math::MinimizerOptions::DefaultMinimizerType() == "Minuit2"; }
+
+//_______________________________________________________________________________
+int FitUtils::Fit( THnBase* h, TF1* f, TString option )
+{
+
+  // quiet mode
+  const bool quiet( option.Contains( "Q" ) );
+  const bool likelihood( option.Contains( "L" ) );
+
+  // active bins
+  BinIndex index;
+  index.Build( h, f, !likelihood );
+  if( !index.GetSize() )
+  {
+    std::cout << "FitUtils::Fit - no bins to fit" << std::endl;
+    return -1;
+  }
+
+  if( !quiet ) std::cout << "FitUtils::Fit - using " << ( likelihood ? "Likelihood":"chisquare" ) << " fitter, active bins: " << index.GetSize() << std::endl;
+
+  const int nPar = f->GetNpar();
+  TMinuit minuit( nPar );
+  minuit.SetPrintLevel( -1 );
+
+  // errors correspond to one unit of chisquare or -2 log(L)
+  int error = 0;
+  double arglist[2] = { 1, 0 };
+  minuit.mnexcm( "SET ERR", arglist, 1, error );
+
+  for( int iP = 0; iP < nPar; ++iP )
+  {
+
+    const double value = f->GetParameter( iP );
+    double step = f->GetParError( iP );
+    if( step <= 0 ) step = value ? 0.1*TMath::Abs( value ):0.1;
+
+    double min = 0;
+    double max = 0;
+    f->GetParLimits( iP, min, max );
+    const bool fixed( min*max != 0 && min >= max );
+    if( fixed || min >= max ) { min = 0; max = 0; }
+
+    minuit.mnparm( iP, f->GetParName( iP ), value, step, min, max, error );
+    if( fixed )
+    {
+      arglist[0] = iP+1;
+      minuit.mnexcm( "FIX", arglist, 1, error );
+    }
+
+  }
+
+  // performance monitoring
+  if( FitMonitor::IsEnabled() )
+  { FitMonitor::Start( Form( "%s/%s", h->GetName(), f->GetName() ), likelihood ? "local likelihood":"local chisquare" ); }
+
+  // minimize
+  gBinIndex = &index;
+  gFunction = f;
+  gLikelihood = likelihood;
+  minuit.SetFCN( BinIndexFcn );
+
+  arglist[0] = 5000;
+  minuit.mnexcm( "MIGRAD", arglist, 1, error );
+  const int status = error;
+  if( !status ) minuit.mnexcm( "HESSE", arglist, 1, error );
+
+  gBinIndex = 0;
+  gFunction = 0;
+  FitMonitor::Stop( status, -1, index.GetSize() );
+
+  // store parameters
+  std::vector<double> parameters( nPar );
+  for( int iP = 0; iP < nPar; ++iP )
+  {
+    double value = 0;
+    double parError = 0;
+    minuit.GetParameter( iP, value, parError );
+    f->SetParameter( iP, value );
+    f->SetParError( iP, parError );
+    parameters[iP] = value;
+  }
+
+  // chisquare and number of fitted points
+  int nFitPoints = 0;
+  f->SetChisquare( ChisquareFitter::Chisquare( index, f, parameters.data(), nFitPoints ) );
+  f->SetNumberFitPoints( nFitPoints );
+
+  if( !quiet ) std::cout << "FitUtils::Fit - status: " << status << " chisquare: " << f->GetChisquare() << " ndf: " << f->GetNDF() << std::endl;
+  return status;
+
+}
 
 //_______________________________________________________________________________
 double FitUtils::Gaus( double x, double mean, double sigma )
@@ -117,8 +386,12 @@ double FitUtils::CrystalBall( double *x, double *par )
   // get normalized Crystal ball
   double result = CrystalBall( x[0], par[1], par[2], par[3], par[4] );
 
-  // get integral
-  double integral = CrystalBallIntegral( par[2], par[3], par[4] );
+  // get integral, only recalculated when shape parameters change
+  // caches are per thread, so that FCN can be evaluated in parallel
+  thread_local IntegralCache<3> cache;
+  const double integral = cache.Matches( par+2 ) ?
+    cache.Get():
+    cache.Store( par+2, CrystalBallIntegral( par[2], par[3], par[4] ) );
 
   // return scaled Crystalball so that par[0] corresponds to integral
   return par[0] * result / integral;
@@ -132,15 +405,9 @@ double FitUtils::CrystalBall( double x, double mean, double sigma, double alpha,
   double t = (x-mean)/sigma;
   if( alpha < 0 ) t *= -1.0;
 
-  alpha = fabs( alpha );
-  if( t >= -alpha ) return TMath::Exp( -ROOT_MACRO::SQUARE( t )/2 );
-  else {
-
-    double a = TMath::Power( n/alpha, n )*TMath::Exp( -ROOT_MACRO::SQUARE( alpha )/2 );
-    double b = n/alpha - alpha;
-    return a/TMath::Power( b - t, n );
-
-  }
+  thread_local CrystalBallTailCache cache;
+  if( t >= -fabs( alpha ) ) return TMath::Exp( -ROOT_MACRO::SQUARE( t )/2 );
+  else return cache.Get( alpha, n ).Eval( t );
 
 }
 
@@ -151,8 +418,11 @@ double FitUtils::CrystalBall2( double *x, double *par )
   // get normalized Crystal ball
   double result = CrystalBall2( x[0], par[1], par[2], par[3], par[4], par[5], par[6] );
 
-  // get integral
-  double integral = CrystalBall2Integral( par[2], par[3], par[4], par[5], par[6] );
+  // get integral, only recalculated when shape parameters change
+  thread_local IntegralCache<5> cache;
+  const double integral = cache.Matches( par+2 ) ?
+    cache.Get():
+    cache.Store( par+2, CrystalBall2Integral( par[2], par[3], par[4], par[5], par[6] ) );
 
   // return scaled Crystalball so that par[0] corresponds to integral
   return par[0] * result/integral;
@@ -163,20 +433,13 @@ double FitUtils::CrystalBall2( double *x, double *par )
 double FitUtils::CrystalBall2( double x, double mean, double sigma, double alpha1, double n1, double alpha2, double n2 )
 {
 
-  double t = (x-mean)/sigma;
-  if( t < -alpha1 )
-  {
-    double a = TMath::Power( n1/alpha1, n1 )*TMath::Exp( -ROOT_MACRO::SQUARE( alpha1 )/2 );
-    double b = n1/alpha1 - alpha1;
-    return a/TMath::Power( b - t, n1 );
-
-  } else if( t > alpha2 ) {
-
-    double a = TMath::Power( n2/alpha2, n2 )*TMath::Exp( -ROOT_MACRO::SQUARE( alpha2 )/2 );
-    double b = n2/alpha2 - alpha2;
-    return a/TMath::Power( b + t, n2 );
+  thread_local CrystalBallTailCache leftCache;
+  thread_local CrystalBallTailCache rightCache;
 
-  } else return TMath::Exp( -ROOT_MACRO::SQUARE( t )/2 );
+  double t = (x-mean)/sigma;
+  if( t < -alpha1 ) return leftCache.Get( alpha1, n1 ).Eval( t );
+  else if( t > alpha2 ) return rightCache.Get( alpha2, n2 ).Eval( -t );
+  else return TMath::Exp( -ROOT_MACRO::SQUARE( t )/2 );
 
 }
 
@@ -311,3 +574,138 @@ double FitUtils::Na60New(
   return TMath::Exp( -ROOT_MACRO::SQUARE( t/sigmaRatio )/2 );
 
 }
+
+//____________________________________________
+void FitUtils::GausIntegrated( const double* x, double* out, int n, const double* par )
+{
+  const double norm = par[0]/(par[2]*std::sqrt(2.0*TMath::Pi()));
+  const double mean = par[1];
+  const double k = -0.5/ROOT_MACRO::SQUARE( par[2] );
+  for( int i = 0; i < n; ++i )
+  { out[i] = norm*std::exp( k*ROOT_MACRO::SQUARE( x[i]-mean ) ); }
+}
+
+//____________________________________________
+void FitUtils::GausIntegratedExp( const double* x, double* out, int n, const double* par )
+{
+  GausIntegrated( x, out, n, par );
+  const double mean = par[1];
+  const double k = -1.0/par[4];
+  for( int i = 0; i < n; ++i )
+  { out[i] += par[3]*std::exp( k*( x[i]-mean ) ); }
+}
+
+//____________________________________________
+void FitUtils::Exp( const double* x, double* out, int n, const double* par )
+{
+  const double k = -par[1];
+  for( int i = 0; i < n; ++i )
+  { out[i] = par[0]*std::exp( k*x[i] ); }
+}
+
+//____________________________________________
+void FitUtils::GausGausIntegratedExp( const double* x, double* out, int n, const double* par )
+{
+  GausGausIntegrated( x, out, n, par );
+  const double k = -1.0/par[7];
+  for( int i = 0; i < n; ++i )
+  { out[i] += par[6]*std::exp( k*x[i] ); }
+}
+
+//____________________________________________
+void FitUtils::GausGausIntegrated( const double* x, double* out, int n, const double* par )
+{
+  const double norm1 = par[0]/(par[2]*std::sqrt(2.0*TMath::Pi()));
+  const double k1 = -0.5/ROOT_MACRO::SQUARE( par[2] );
+  const double norm2 = par[3]/(par[5]*std::sqrt(2.0*TMath::Pi()));
+  const double k2 = -0.5/ROOT_MACRO::SQUARE( par[5] );
+  for( int i = 0; i < n; ++i )
+  {
+    out[i] =
+      norm1*std::exp( k1*ROOT_MACRO::SQUARE( x[i]-par[1] ) ) +
+      norm2*std::exp( k2*ROOT_MACRO::SQUARE( x[i]-par[4] ) );
+  }
+}
+
+//____________________________________________
+void FitUtils::CrystalBall0( const double* x, double* out, int n, const double* par )
+{
+  const double mean = par[1];
+  const double sign = par[3] < 0 ? -1.0:1.0;
+  const double invSigma = sign/par[2];
+  const CrystalBallTail tail( par[3], par[4] );
+  for( int i = 0; i < n; ++i )
+  {
+    const double t = ( x[i]-mean )*invSigma;
+    out[i] = par[0]*( t >= -tail.fAlpha ? std::exp( -ROOT_MACRO::SQUARE( t )/2 ):tail.Eval( t ) );
+  }
+}
+
+//____________________________________________
+void FitUtils::CrystalBall( const double* x, double* out, int n, const double* par )
+{
+  // scale so that par[0] corresponds to integral
+  const double scaled[5] = { par[0]/CrystalBallIntegral( par[2], par[3], par[4] ), par[1], par[2], par[3], par[4] };
+  CrystalBall0( x, out, n, scaled );
+}
+
+//____________________________________________
+void FitUtils::CrystalBall2( const double* x, double* out, int n, const double* par )
+{
+  const double norm = par[0]/CrystalBall2Integral( par[2], par[3], par[4], par[5], par[6] );
+  const double mean = par[1];
+  const double invSigma = 1.0/par[2];
+  const CrystalBallTail left( par[3], par[4] );
+  const CrystalBallTail right( par[5], par[6] );
+  for( int i = 0; i < n; ++i )
+  {
+    const double t = ( x[i]-mean )*invSigma;
+    out[i] = norm*(
+      t < -par[3] ? left.Eval( t ):
+      t > par[5] ? right.Eval( -t ):
+      std::exp( -ROOT_MACRO::SQUARE( t )/2 ) );
+  }
+}
+
+//____________________________________________
+void FitUtils::VWG( const double* x, double* out, int n, const double* par )
+{
+  const double mean = par[1];
+  const double slope = par[3]/mean;
+  for( int i = 0; i < n; ++i )
+  {
+    const double dx = x[i]-mean;
+    out[i] = par[0]*std::exp( -0.5*ROOT_MACRO::SQUARE( dx/( par[2] + slope*dx ) ) );
+  }
+}
+
+//____________________________________________
+void FitUtils::VWG2( const double* x, double* out, int n, const double* par )
+{
+  const double mean = par[1];
+  const double slope = par[3]/mean;
+  const double slopeQuad = par[4]/ROOT_MACRO::SQUARE( mean );
+  for( int i = 0; i < n; ++i )
+  {
+    const double dx = x[i]-mean;
+    out[i] = par[0]*std::exp( -0.5*ROOT_MACRO::SQUARE( dx/( par[2] + dx*( slope + slopeQuad*dx ) ) ) );
+  }
+}
+
+//____________________________________________
+void FitUtils::Na60Old( const double* x, double* out, int n, const double* par )
+{
+  double tail1[3] = { par[3], par[4], par[5] };
+  double tail2[3] = { par[6], par[7], par[8] };
+  for( int i = 0; i < n; ++i )
+  { out[i] = par[0]*Na60Old( x[i], par[1], par[2], tail1, tail2, par[9], par[10] ); }
+}
+
+//____________________________________________
+void FitUtils::Na60New( const double* x, double* out, int n, const double* par )
+{
+  double tail1[3] = { par[3], par[4], par[5] };
+  double tail2[3] = { par[6], par[7], par[8] };
+  for( int i = 0; i < n; ++i )
+  { out[i] = par[0]*Na60New( x[i], par[1], par[2], tail1, tail2, par[9], par[10] ); }
+}
@@ -7,6 +7,8 @@
 #include <TF1.h>
 #include <TFitResultPtr.h>
 
+class THnBase;
+
 /*!
 	\class   Fit
 	\brief   some usefull functions for fits
@@ -20,8 +22,21 @@ namespace UTILS
 
     public:
 
-    /// fit
-    static TFitResultPtr Fit( TH1*, TF1*, TString );
+    /*!
+    fit. Option "U" uses local fitters, "Q" suppresses printout.
+    Local fitters only loop over active bins, excluding bins for which the optional mask is empty
+    */
+    static TFitResultPtr Fit( TH1*, TF1*, TString, const TH1* mask = 0 );
+
+    /// fit n-dimensional histogram (up to 3 dimensions) using local fitters. Returns minuit status
+    static int Fit( THnBase*, TF1*, TString );
+
+    /*!
+    true if fits with this option can run concurrently, each thread using its own histogram and function.
+    Local fitters are installed in the global virtual fitter, and the default TMinuit based minimizer
+    shares a single TMinuit instance. Only Minuit2, set as default minimizer, has no shared state
+    */
+    static bool IsThreadSafe( const TString& option );
 
     //* normalized gauss
     static double Gaus( double x, double mean, double sigma );
@@ -115,6 +130,51 @@ namespace UTILS
       double alpha1, double alpha2
       );
 
+    //*@name batch evaluation
+    /*!
+    evaluate n points at once, x and out are arrays of size n.
+    Parameter-only constants are calculated once per call
+    */
+    //@{
+
+    //* gaussian, using integral for first parameter
+    static void GausIntegrated( const double* x, double* out, int n, const double* par );
+
+    //* 1 gaussian, using integral for first parameter + exp
+    static void GausIntegratedExp( const double* x, double* out, int n, const double* par );
+
+    //* 2 parameters exponential
+    static void Exp( const double* x, double* out, int n, const double* par );
+
+    //* 2 gaussian, using integral for first parameter + exp
+    static void GausGausIntegratedExp( const double* x, double* out, int n, const double* par );
+
+    //* 2 gaussian (integ,ave,sigma)+exp
+    static void GausGausIntegrated( const double* x, double* out, int n, const double* par );
+
+    //* Crystall ball fit, using Amplitude for first parameter
+    static void CrystalBall0( const double* x, double* out, int n, const double* par );
+
+    //* Crystal ball, using integral for first parameter
+    static void CrystalBall( const double* x, double* out, int n, const double* par );
+
+    //* Crystal ball (with tails on both sides), using integral for first parameter
+    static void CrystalBall2( const double* x, double* out, int n, const double* par );
+
+    //* variable width gaussian
+    static void VWG( const double* x, double* out, int n, const double* par );
+
+    //* variable width gaussian
+    static void VWG2( const double* x, double* out, int n, const double* par );
+
+    //* Na60 function
+    static void Na60Old( const double* x, double* out, int n, const double* par );
+
+    //* Na60 function
+    static void Na60New( const double* x, double* out, int n, const double* par );
+
+    //@}
+
     ClassDef(FitUtils,0)
   };
 
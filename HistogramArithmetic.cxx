@@ -0,0 +1,219 @@
+#include "HistogramArithmetic.h"
+#include "Utils.h"
+
+#include <TArrayD.h>
+#include <TArrayF.h>
+#include <TH1.h>
+#include <TMath.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+#include <TProfile3D.h>
+
+#include <algorithm>
+#include <cmath>
+
+/*!
+  \file HistogramArithmetic.cxx
+  \brief array level histogram arithmetic
+*/
+
+namespace
+{
+
+  //____________________________________________
+  //* profile array storage and Sumw2 hold sums, not bin contents and squared errors
+  bool IsProfile( const TH1* h )
+  {
+    return
+      h->InheritsFrom( TProfile::Class() ) ||
+      h->InheritsFrom( TProfile2D::Class() ) ||
+      h->InheritsFrom( TProfile3D::Class() );
+  }
+
+  //____________________________________________
+  //* copy array storage, converted to double
+  template<class T> void Copy( const T* in, std::vector<double>& out, int n )
+  { out.assign( in, in+n ); }
+
+  //____________________________________________
+  //* call function for each row of visible bins along x, with first global bin and number of bins
+  template<class F> int ForEachRow( const TH1* h, F function )
+  {
+    const int nX = h->GetNbinsX();
+    const int nY = h->GetNbinsY();
+    const int nZ = h->GetNbinsZ();
+    for( int iZ = 1; iZ <= nZ; ++iZ )
+      for( int iY = 1; iY <= nY; ++iY )
+    { function( h->GetBin( 1, iY, iZ ), nX ); }
+
+    return nX*nY*nZ;
+  }
+
+  //____________________________________________
+  //* store visible bins into array storage
+  template<class T> int Store( const TH1* h, T* out, const double* in )
+  { return ForEachRow( h, [&]( int first, int n ) { std::copy( in+first, in+first+n, out+first ); } ); }
+
+}
+
+//__________________________________________________________________
+void HistogramArithmetic::GetContents( const TH1* h, std::vector<double>& contents, std::vector<double>& variances )
+{
+
+  const int n = h->GetNcells();
+
+  // profiles. Use accessors
+  if( IsProfile( h ) )
+  {
+    contents.resize( n );
+    variances.resize( n );
+    for( int bin = 0; bin < n; ++bin )
+    {
+      contents[bin] = h->GetBinContent( bin );
+      variances[bin] = TMath::Power( h->GetBinError( bin ), 2 );
+    }
+    return;
+  }
+
+  // contents, from array storage when possible
+  if( const TArrayD* array = dynamic_cast<const TArrayD*>( h ) ) Copy( array->GetArray(), contents, n );
+  else if( const TArrayF* array = dynamic_cast<const TArrayF*>( h ) ) Copy( array->GetArray(), contents, n );
+  else {
+    contents.resize( n );
+    for( int bin = 0; bin < n; ++bin ) contents[bin] = h->GetBinContent( bin );
+  }
+
+  // squared errors, from Sumw2 when possible
+  if( h->GetBinErrorOption() != TH1::kNormal )
+  {
+
+    // asymmetric errors. Use GetBinError
+    variances.resize( n );
+    for( int bin = 0; bin < n; ++bin ) variances[bin] = TMath::Power( h->GetBinError( bin ), 2 );
+
+  } else if( h->GetSumw2N() ) {
+
+    Copy( h->GetSumw2()->GetArray(), variances, n );
+
+  } else {
+
+    // no Sumw2, error is sqrt(|content|)
+    variances.resize( n );
+    for( int bin = 0; bin < n; ++bin ) variances[bin] = std::abs( contents[bin] );
+
+  }
+
+}
+
+//__________________________________________________________________
+void HistogramArithmetic::SetContents( TH1* h, const double* contents, const double* variances )
+{
+
+  // profiles. Use accessors
+  if( IsProfile( h ) )
+  {
+    ForEachRow( h, [&]( int first, int n )
+    {
+      for( int bin = first; bin < first+n; ++bin )
+      {
+        h->SetBinContent( bin, contents[bin] );
+        h->SetBinError( bin, TMath::Sqrt( variances[bin] ) );
+      }
+    } );
+    return;
+  }
+
+  // make sure squared errors are stored
+  if( !h->GetSumw2N() ) h->Sumw2();
+
+  const double entries = h->GetEntries();
+
+  int nBins = 0;
+  if( TArrayD* array = dynamic_cast<TArrayD*>( h ) ) nBins = Store( h, array->GetArray(), contents );
+  else if( TArrayF* array = dynamic_cast<TArrayF*>( h ) ) nBins = Store( h, array->GetArray(), contents );
+  else {
+
+    // other storage types
+    nBins = ForEachRow( h, [&]( int first, int n )
+      { for( int bin = first; bin < first+n; ++bin ) h->SetBinContent( bin, contents[bin] ); } );
+
+  }
+
+  Store( h, h->GetSumw2()->GetArray(), variances );
+
+  // statistics are recalculated from bin contents when needed
+  double stats[13] = { 0 };
+  h->PutStats( stats );
+  h->SetEntries( entries + nBins );
+
+}
+
+//__________________________________________________________________
+void HistogramArithmetic::Subtract(
+  const double* contents1, const double* variances1,
+  const double* contents2, const double* variances2,
+  double* contents, double* variances, int n )
+{
+  for( int i = 0; i < n; ++i )
+  {
+    contents[i] = contents1[i] - contents2[i];
+    variances[i] = variances1[i] + variances2[i];
+  }
+}
+
+//__________________________________________________________________
+void HistogramArithmetic::Divide(
+  const double* contents1, const double* contents2,
+  double* contents, double* variances, int n, int errorMode )
+{
+
+  // value used when the error is zero, squared
+  const double minVariance = 1e-10;
+
+  // ratio
+  for( int i = 0; i < n; ++i )
+  {
+    const double b2 = contents2[i];
+    contents[i] = b2 != 0 ? contents1[i]/( b2 != 0 ? b2:1 ):0;
+  }
+
+  switch( errorMode )
+  {
+
+    case Utils::EFF:
+    for( int i = 0; i < n; ++i )
+    {
+      const double b1 = contents1[i];
+      const double b2 = contents2[i];
+      const double b3 = contents[i];
+      const double variance = b2 != 0 ? b3*(1-b3)/( b2 != 0 ? b2:1 ):0;
+      variances[i] = ( b2 != 0 && ( b1 == b2 || b1 == 0 ) ) ? minVariance:variance;
+    }
+    break;
+
+    case Utils::BAYES:
+    for( int i = 0; i < n; ++i )
+    {
+      // posterior variance, for a uniform prior
+      const double b1 = contents1[i];
+      const double b2 = contents2[i];
+      const double mean = ( b1+1 )/( b2+2 );
+      variances[i] = ( b1+1 )*( b1+2 )/( ( b2+2 )*( b2+3 ) ) - mean*mean;
+    }
+    break;
+
+    default:
+    for( int i = 0; i < n; ++i )
+    {
+      const double b1 = contents1[i];
+      const double b2 = contents2[i];
+      const double b3 = contents[i];
+      const double relVariance = ( b1 != 0 ? 1/( b1 != 0 ? b1:1 ):0 ) + ( b2 != 0 ? 1/( b2 != 0 ? b2:1 ):0 );
+      const double variance = b3*b3*relVariance;
+      variances[i] = variance == 0 ? minVariance:variance;
+    }
+    break;
+
+  }
+
+}
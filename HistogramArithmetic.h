@@ -0,0 +1,53 @@
+#ifndef HistogramArithmetic_h
+#define HistogramArithmetic_h
+
+/*!
+\file    HistogramArithmetic.h
+\brief   array level histogram arithmetic
+*/
+
+#include <TROOT.h>
+
+#include <vector>
+
+class TH1;
+
+/*!
+\class   HistogramArithmetic
+\brief   array level histogram arithmetic
+
+Histogram contents and squared errors are read once into contiguous arrays, directly
+from TH1D/TH1F (and 2D, 3D) storage and Sumw2 when available. Profiles, whose storage
+holds sums rather than bin contents, go through GetBinContent and GetBinError. Bin by bin operations
+are then performed by branch free loops over these arrays, and results are written
+back to the output storage in one pass. Error modes follow Utils::ErrorMode.
+*/
+class HistogramArithmetic
+{
+
+  public:
+
+  //! contents and squared errors for all cells, including under and overflow
+  static void GetContents( const TH1* h, std::vector<double>& contents, std::vector<double>& variances );
+
+  /*!
+  store contents and squared errors for all bins that are not under or overflow.
+  Arrays are indexed by global bin number. Like SetBinContent, the number of entries is
+  incremented for each stored bin and statistics are recalculated from bin contents
+  */
+  static void SetContents( TH1* h, const double* contents, const double* variances );
+
+  //! difference and squared error
+  static void Subtract(
+    const double* contents1, const double* variances1,
+    const double* contents2, const double* variances2,
+    double* contents, double* variances, int n );
+
+  //! ratio and squared error, according to error mode
+  static void Divide(
+    const double* contents1, const double* contents2,
+    double* contents, double* variances, int n, int errorMode );
+
+};
+
+#endif
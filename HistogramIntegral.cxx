@@ -0,0 +1,232 @@
+#include "HistogramIntegral.h"
+#include "HistogramArithmetic.h"
+#include "Reduction.h"
+
+#include <TAxis.h>
+#include <TH1.h>
+#include <TMath.h>
+
+#include <algorithm>
+#include <iostream>
+
+/*!
+  \file HistogramIntegral.cxx
+  \brief cumulative sums of histogram contents and squared errors
+*/
+
+//__________________________________________________________________
+HistogramIntegral::Binning::Binning( const TAxis* axis ):
+  fNBins( axis ? axis->GetNbins():0 ),
+  fVariable( axis ? axis->GetXbins()->fN > 0:false ),
+  fXMin( axis ? axis->GetXmin():0 ),
+  fXMax( axis ? axis->GetXmax():0 )
+{
+  if( !axis ) return;
+
+  // edges are taken from the axis, so that under and overflow edges match TAxis conventions
+  fEdges.resize( fNBins+3 );
+  for( int bin = 0; bin <= fNBins+1; ++bin ) fEdges[bin] = axis->GetBinLowEdge( bin );
+  fEdges[fNBins+2] = axis->GetBinUpEdge( fNBins+1 );
+}
+
+//__________________________________________________________________
+int HistogramIntegral::Binning::FindBin( double x ) const
+{
+  if( x < fXMin ) return 0;
+  else if( !( x < fXMax ) ) return fNBins+1;
+  else if( !fVariable ) return 1 + int( fNBins*( x - fXMin )/( fXMax - fXMin ) );
+  else {
+
+    // last visible bin with low edge smaller or equal to x
+    return int( std::upper_bound( fEdges.begin()+1, fEdges.begin()+fNBins+1, x ) - fEdges.begin() ) - 1;
+
+  }
+}
+
+//__________________________________________________________________
+void HistogramIntegral::Binning::GetWindow( double xmin, double xmax, int& bin1, int& bin2, double& lowFraction, double& highFraction ) const
+{
+  bin1 = FindBin( xmin );
+  bin2 = FindBin( xmax );
+  lowFraction = ( xmin - fEdges[bin1] )/( fEdges[bin1+1] - fEdges[bin1] );
+  highFraction = ( fEdges[bin2+1] - xmax )/( fEdges[bin2+1] - fEdges[bin2] );
+}
+
+//__________________________________________________________________
+HistogramIntegral::HistogramIntegral( const TH1* h, int axis ):
+  fNBins( 0 ),
+  fFirst( 0 ),
+  fLast( 0 )
+{
+
+  if( axis < 0 || axis >= h->GetDimension() )
+  {
+    std::cout << "HistogramIntegral::HistogramIntegral - invalid axis " << axis << " for " << h->GetName() << std::endl;
+    axis = 0;
+  }
+
+  const TAxis* axes[3] = { h->GetXaxis(), h->GetYaxis(), h->GetZaxis() };
+  fBinning = Binning( axes[axis] );
+  fNBins = axes[axis]->GetNbins();
+  fFirst = axes[axis]->GetFirst();
+  fLast = axes[axis]->GetLast();
+
+  // contents and squared errors for all cells
+  std::vector<double> contents;
+  std::vector<double> variances;
+  HistogramArithmetic::GetContents( h, contents, variances );
+
+  // project on requested axis
+  std::vector<double> projectedContents( fNBins+2, 0 );
+  std::vector<double> projectedVariances( fNBins+2, 0 );
+  if( h->GetDimension() == 1 )
+  {
+
+    projectedContents.swap( contents );
+    projectedVariances.swap( variances );
+
+  } else {
+
+    // bin range along each axis: along projection axis, all cells; along other axes, axis range if set, all cells otherwise
+    int first[3] = { 0, 0, 0 };
+    int last[3] = { 0, 0, 0 };
+    for( int i = 0; i < h->GetDimension(); ++i )
+    {
+      const bool useRange( i != axis && axes[i]->TestBit( TAxis::kAxisRange ) );
+      first[i] = useRange ? axes[i]->GetFirst():0;
+      last[i] = useRange ? axes[i]->GetLast():axes[i]->GetNbins()+1;
+    }
+
+    std::vector<Reduction::Accumulator> contentSums( fNBins+2 );
+    std::vector<Reduction::Accumulator> varianceSums( fNBins+2 );
+    int index[3];
+    for( index[2] = first[2]; index[2] <= last[2]; ++index[2] )
+      for( index[1] = first[1]; index[1] <= last[1]; ++index[1] )
+      for( index[0] = first[0]; index[0] <= last[0]; ++index[0] )
+    {
+      const int bin = h->GetBin( index[0], index[1], index[2] );
+      contentSums[index[axis]].Add( contents[bin] );
+      varianceSums[index[axis]].Add( variances[bin] );
+    }
+
+    for( int i = 0; i < fNBins+2; ++i )
+    {
+      projectedContents[i] = contentSums[i].Get();
+      projectedVariances[i] = varianceSums[i].Get();
+    }
+
+  }
+
+  // cumulative sums
+  fContents.assign( fNBins+3, 0 );
+  fContentCompensations.assign( fNBins+3, 0 );
+  fVariances.assign( fNBins+3, 0 );
+  fVarianceCompensations.assign( fNBins+3, 0 );
+
+  Reduction::Accumulator contentSum;
+  Reduction::Accumulator varianceSum;
+  for( int i = 0; i < fNBins+2; ++i )
+  {
+    contentSum.Add( projectedContents[i] );
+    varianceSum.Add( projectedVariances[i] );
+    fContents[i+1] = contentSum.GetSum();
+    fContentCompensations[i+1] = contentSum.GetCompensation();
+    fVariances[i+1] = varianceSum.GetSum();
+    fVarianceCompensations[i+1] = varianceSum.GetCompensation();
+  }
+
+}
+
+//__________________________________________________________________
+void HistogramIntegral::Clamp( int& bin1, int& bin2 ) const
+{
+  if( bin1 < 0 ) bin1 = 0;
+  if( bin2 > fNBins+1 || bin2 < bin1 ) bin2 = fNBins+1;
+}
+
+//__________________________________________________________________
+double HistogramIntegral::Integral( int bin1, int bin2 ) const
+{
+  Clamp( bin1, bin2 );
+  return Difference( fContents, fContentCompensations, bin1, bin2+1 );
+}
+
+//__________________________________________________________________
+double HistogramIntegral::IntegralAndError( int bin1, int bin2, double& error ) const
+{
+  Clamp( bin1, bin2 );
+  error = TMath::Sqrt( Difference( fVariances, fVarianceCompensations, bin1, bin2+1 ) );
+  return Difference( fContents, fContentCompensations, bin1, bin2+1 );
+}
+
+//__________________________________________________________________
+double HistogramIntegral::Integral( void ) const
+{ return Integral( fFirst, fLast ); }
+
+//__________________________________________________________________
+double HistogramIntegral::Integrate( double xmin, double xmax ) const
+{
+
+  // check order
+  if( xmin >= xmax )
+  {
+    std::cout << "HistogramIntegral::Integrate - invalid range" << std::endl;
+    return 0;
+  }
+
+  return WindowIntegral( xmin, xmax );
+
+}
+
+//__________________________________________________________________
+void HistogramIntegral::Integrate( const double* xmin, const double* xmax, double* out, int n ) const
+{
+
+  int invalid = 0;
+  for( int i = 0; i < n; ++i )
+  {
+    if( xmin[i] >= xmax[i] )
+    {
+      out[i] = 0;
+      ++invalid;
+    } else out[i] = WindowIntegral( xmin[i], xmax[i] );
+  }
+
+  if( invalid )
+  { std::cout << "HistogramIntegral::Integrate - " << invalid << " invalid ranges out of " << n << std::endl; }
+
+}
+
+//__________________________________________________________________
+double HistogramIntegral::WindowIntegral( double xmin, double xmax ) const
+{
+
+  // find bins matching xmin and xmax. Bins are always in [0, n+1] and ordered
+  int binMin = 0;
+  int binMax = 0;
+  double lowFraction = 0;
+  double highFraction = 0;
+  fBinning.GetWindow( xmin, xmax, binMin, binMax, lowFraction, highFraction );
+
+  // need to correct (linearly) from the bound bins
+  return
+    Difference( fContents, fContentCompensations, binMin, binMax+1 )
+    - Difference( fContents, fContentCompensations, binMin, binMin+1 )*lowFraction
+    - Difference( fContents, fContentCompensations, binMax, binMax+1 )*highFraction;
+
+}
+
+//__________________________________________________________________
+void HistogramIntegral::GetCumulative( bool inverse, bool includeOverflow, std::vector<double>& contents, std::vector<double>& errors ) const
+{
+
+  contents.resize( fNBins );
+  errors.resize( fNBins );
+  for( int bin = 1; bin <= fNBins; ++bin )
+  {
+    const int bin1 = inverse ? bin:( includeOverflow ? 0:1 );
+    const int bin2 = inverse ? ( includeOverflow ? fNBins+1:fNBins ):bin;
+    contents[bin-1] = IntegralAndError( bin1, bin2, errors[bin-1] );
+  }
+
+}
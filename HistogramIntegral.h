@@ -0,0 +1,147 @@
+#ifndef HistogramIntegral_h
+#define HistogramIntegral_h
+
+/*!
+\file    HistogramIntegral.h
+\brief   cumulative sums of histogram contents and squared errors
+*/
+
+#include <TROOT.h>
+
+#include <vector>
+
+class TAxis;
+class TH1;
+
+/*!
+\class   HistogramIntegral
+\brief   cumulative sums of histogram contents and squared errors
+
+Cumulative sums are built in one pass over all cells of a 1D histogram, or of the
+projection of a 2D/3D histogram on one of its axes, including under and overflow.
+Sums are stored with a compensation term, so that differences between two cumulative
+sums keep full precision. Integrals over any bin range are then obtained in constant
+time, with the same bin range conventions as TH1::Integral.
+
+For projections, bins along other axes are summed over the axis range if one is set,
+and over all bins, including under and overflow, otherwise, as in TH2::ProjectionX.
+
+Axis bin edges are cached as well, so that repeated window integrals, as used in
+sliding window scans, involve no call to the histogram or its axis.
+*/
+class HistogramIntegral
+{
+
+  public:
+
+  /*!
+  cached axis bin edges, for bin lookup and fraction of boundary bins
+  Bin lookup is the same as TAxis::FindFixBin
+  */
+  class Binning
+  {
+
+    public:
+
+    //! constructor
+    Binning( const TAxis* axis = 0 );
+
+    //! number of bins
+    int GetNbins( void ) const
+    { return fNBins; }
+
+    //! bin matching value
+    int FindBin( double x ) const;
+
+    //! bin range matching [xmin, xmax], and fractions of the boundary bins outside of it
+    void GetWindow( double xmin, double xmax, int& bin1, int& bin2, double& lowFraction, double& highFraction ) const;
+
+    private:
+
+    //! number of bins
+    int fNBins;
+
+    //! true for variable bin size
+    bool fVariable;
+
+    //! axis minimum
+    double fXMin;
+
+    //! axis maximum
+    double fXMax;
+
+    //! low edges of all bins including under and overflow, followed by overflow upper edge
+    std::vector<double> fEdges;
+
+  };
+
+  //! constructor. Axis is 0, 1, 2 for x, y, z
+  HistogramIntegral( const TH1* h, int axis = 0 );
+
+  //! number of bins along axis
+  int GetNbins( void ) const
+  { return fNBins; }
+
+  //! sum of contents for bins in [bin1, bin2]. Bins are clamped as in TH1::Integral
+  double Integral( int bin1, int bin2 ) const;
+
+  //! sum of contents and error for bins in [bin1, bin2]. Bins are clamped as in TH1::Integral
+  double IntegralAndError( int bin1, int bin2, double& error ) const;
+
+  //! sum of contents over axis range
+  double Integral( void ) const;
+
+  /*!
+  sum of contents between two axis values, linearly corrected for the fraction
+  of the boundary bins outside of the range. Same as Utils::Integrate
+  */
+  double Integrate( double xmin, double xmax ) const;
+
+  //! window integrals for n windows [xmin[i], xmax[i]]. Invalid windows give zero
+  void Integrate( const double* xmin, const double* xmax, double* out, int n ) const;
+
+  /*!
+  cumulative contents and errors for bins 1 to n. Forward sums start from the first bin,
+  inverse sums from the last bin. Under or overflow is included on request
+  */
+  void GetCumulative( bool inverse, bool includeOverflow, std::vector<double>& contents, std::vector<double>& errors ) const;
+
+  private:
+
+  //! clamp bins as in TH1::Integral
+  void Clamp( int& bin1, int& bin2 ) const;
+
+  //! window integral, for a valid window
+  double WindowIntegral( double xmin, double xmax ) const;
+
+  //! difference between cumulative sums, from bin1 included to bin2 excluded
+  static double Difference( const std::vector<double>& sums, const std::vector<double>& compensations, int bin1, int bin2 )
+  { return ( sums[bin2] - sums[bin1] ) + ( compensations[bin2] - compensations[bin1] ); }
+
+  //! axis binning
+  Binning fBinning;
+
+  //! number of bins
+  int fNBins;
+
+  //! first bin of axis range
+  int fFirst;
+
+  //! last bin of axis range
+  int fLast;
+
+  //! cumulative contents. Element i is the sum over cells 0 to i-1
+  std::vector<double> fContents;
+
+  //! cumulative contents compensation
+  std::vector<double> fContentCompensations;
+
+  //! cumulative squared errors
+  std::vector<double> fVariances;
+
+  //! cumulative squared errors compensation
+  std::vector<double> fVarianceCompensations;
+
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "HistogramIntegral2D.h"
+#include "HistogramArithmetic.h"
+#include "Reduction.h"
+
+#include <TAxis.h>
+#include <TH2.h>
+#include <TMath.h>
+
+#include <iostream>
+
+/*!
+  \file HistogramIntegral2D.cxx
+  \brief summed area table of 2D histogram contents and squared errors
+*/
+
+//__________________________________________________________________
+HistogramIntegral2D::HistogramIntegral2D( const TH2* h ):
+  fXBinning( h->GetXaxis() ),
+  fYBinning( h->GetYaxis() ),
+  fNBinsX( h->GetNbinsX() ),
+  fNBinsY( h->GetNbinsY() ),
+  fStride( fNBinsX+3 )
+{
+
+  // contents and squared errors for all cells
+  std::vector<double> contents;
+  std::vector<double> variances;
+  HistogramArithmetic::GetContents( h, contents, variances );
+
+  const int size = fStride*( fNBinsY+3 );
+  fContents.assign( size, 0 );
+  fContentCompensations.assign( size, 0 );
+  fVariances.assign( size, 0 );
+  fVarianceCompensations.assign( size, 0 );
+
+  // cumulative sums along each row, accumulated along columns
+  std::vector<Reduction::Accumulator> contentColumns( fNBinsX+2 );
+  std::vector<Reduction::Accumulator> varianceColumns( fNBinsX+2 );
+  for( int iy = 0; iy <= fNBinsY+1; ++iy )
+  {
+
+    Reduction::Accumulator contentRow;
+    Reduction::Accumulator varianceRow;
+    for( int ix = 0; ix <= fNBinsX+1; ++ix )
+    {
+
+      const int bin = h->GetBin( ix, iy );
+      contentRow.Add( contents[bin] );
+      varianceRow.Add( variances[bin] );
+
+      contentColumns[ix].Add( contentRow.GetSum() );
+      contentColumns[ix].Add( contentRow.GetCompensation() );
+      varianceColumns[ix].Add( varianceRow.GetSum() );
+      varianceColumns[ix].Add( varianceRow.GetCompensation() );
+
+      const int index = ( iy+1 )*fStride + ix+1;
+      fContents[index] = contentColumns[ix].GetSum();
+      fContentCompensations[index] = contentColumns[ix].GetCompensation();
+      fVariances[index] = varianceColumns[ix].GetSum();
+      fVarianceCompensations[index] = varianceColumns[ix].GetCompensation();
+
+    }
+
+  }
+
+}
+
+//__________________________________________________________________
+void HistogramIntegral2D::Clamp( int& binx1, int& binx2, int& biny1, int& biny2 ) const
+{
+  if( binx1 < 0 ) binx1 = 0;
+  if( binx2 > fNBinsX+1 || binx2 < binx1 ) binx2 = fNBinsX+1;
+  if( biny1 < 0 ) biny1 = 0;
+  if( biny2 > fNBinsY+1 || biny2 < biny1 ) biny2 = fNBinsY+1;
+}
+
+//__________________________________________________________________
+double HistogramIntegral2D::Integral( int binx1, int binx2, int biny1, int biny2 ) const
+{
+  Clamp( binx1, binx2, biny1, biny2 );
+  return Rectangle( fContents, fContentCompensations, binx1, binx2+1, biny1, biny2+1 );
+}
+
+//__________________________________________________________________
+double HistogramIntegral2D::IntegralAndError( int binx1, int binx2, int biny1, int biny2, double& error ) const
+{
+  Clamp( binx1, binx2, biny1, biny2 );
+  error = TMath::Sqrt( Rectangle( fVariances, fVarianceCompensations, binx1, binx2+1, biny1, biny2+1 ) );
+  return Rectangle( fContents, fContentCompensations, binx1, binx2+1, biny1, biny2+1 );
+}
+
+//__________________________________________________________________
+double HistogramIntegral2D::Integrate( double xmin, double xmax, double ymin, double ymax ) const
+{
+
+  // check order
+  if( xmin >= xmax || ymin >= ymax )
+  {
+    std::cout << "HistogramIntegral2D::Integrate - invalid range" << std::endl;
+    return 0;
+  }
+
+  return WindowIntegral( xmin, xmax, ymin, ymax );
+
+}
+
+//__________________________________________________________________
+void HistogramIntegral2D::Integrate( const double* xmin, const double* xmax, const double* ymin, const double* ymax, double* out, int n ) const
+{
+
+  int invalid = 0;
+  for( int i = 0; i < n; ++i )
+  {
+    if( xmin[i] >= xmax[i] || ymin[i] >= ymax[i] )
+    {
+      out[i] = 0;
+      ++invalid;
+    } else out[i] = WindowIntegral( xmin[i], xmax[i], ymin[i], ymax[i] );
+  }
+
+  if( invalid )
+  { std::cout << "HistogramIntegral2D::Integrate - " << invalid << " invalid ranges out of " << n << std::endl; }
+
+}
+
+//__________________________________________________________________
+double HistogramIntegral2D::WindowIntegral( double xmin, double xmax, double ymin, double ymax ) const
+{
+
+  /*
+  along each axis, the window weight of a bin is one over the full bin range,
+  minus the fraction outside of the window for each of the two boundary bins.
+  The window integral is the sum over the product of x and y terms
+  */
+  int xFirst[3];
+  int xLast[3];
+  double xWeight[3];
+  fXBinning.GetWindow( xmin, xmax, xFirst[0], xLast[0], xWeight[1], xWeight[2] );
+  xWeight[0] = 1;
+  xWeight[1] = -xWeight[1];
+  xWeight[2] = -xWeight[2];
+  xFirst[1] = xLast[1] = xFirst[0];
+  xFirst[2] = xLast[2] = xLast[0];
+
+  int yFirst[3];
+  int yLast[3];
+  double yWeight[3];
+  fYBinning.GetWindow( ymin, ymax, yFirst[0], yLast[0], yWeight[1], yWeight[2] );
+  yWeight[0] = 1;
+  yWeight[1] = -yWeight[1];
+  yWeight[2] = -yWeight[2];
+  yFirst[1] = yLast[1] = yFirst[0];
+  yFirst[2] = yLast[2] = yLast[0];
+
+  double out = 0;
+  for( int j = 0; j < 3; ++j )
+    for( int i = 0; i < 3; ++i )
+  { out += xWeight[i]*yWeight[j]*Rectangle( fContents, fContentCompensations, xFirst[i], xLast[i]+1, yFirst[j], yLast[j]+1 ); }
+
+  return out;
+
+}
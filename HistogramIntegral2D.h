@@ -0,0 +1,107 @@
+#ifndef HistogramIntegral2D_h
+#define HistogramIntegral2D_h
+
+/*!
+\file    HistogramIntegral2D.h
+\brief   summed area table of 2D histogram contents and squared errors
+*/
+
+#include "HistogramIntegral.h"
+
+#include <TROOT.h>
+
+#include <vector>
+
+class TH2;
+
+/*!
+\class   HistogramIntegral2D
+\brief   summed area table of 2D histogram contents and squared errors
+
+The 2D counterpart of HistogramIntegral. Cumulative sums over all cells below and left
+of each cell, including under and overflow, are built in one pass, so that integrals over
+any rectangle of bins are obtained from four table entries, with the same bin range
+conventions as TH2::Integral.
+
+Window integrals between axis values are linearly corrected for the fraction of the
+boundary rows and columns outside of the window, as Utils::Integrate does in 1D. They
+combine at most nine rectangles, independently of the window size.
+*/
+class HistogramIntegral2D
+{
+
+  public:
+
+  //! constructor
+  HistogramIntegral2D( const TH2* h );
+
+  //! number of bins along x
+  int GetNbinsX( void ) const
+  { return fNBinsX; }
+
+  //! number of bins along y
+  int GetNbinsY( void ) const
+  { return fNBinsY; }
+
+  //! sum of contents for bins in [binx1, binx2] x [biny1, biny2]. Bins are clamped as in TH2::Integral
+  double Integral( int binx1, int binx2, int biny1, int biny2 ) const;
+
+  //! sum of contents and error for bins in [binx1, binx2] x [biny1, biny2]. Bins are clamped as in TH2::Integral
+  double IntegralAndError( int binx1, int binx2, int biny1, int biny2, double& error ) const;
+
+  //! sum of contents in window, linearly corrected for the fraction of the boundary bins outside of it
+  double Integrate( double xmin, double xmax, double ymin, double ymax ) const;
+
+  //! window integrals for n windows. Invalid windows give zero
+  void Integrate( const double* xmin, const double* xmax, const double* ymin, const double* ymax, double* out, int n ) const;
+
+  private:
+
+  //! clamp bins as in TH2::Integral
+  void Clamp( int& binx1, int& binx2, int& biny1, int& biny2 ) const;
+
+  //! window integral, for a valid window
+  double WindowIntegral( double xmin, double xmax, double ymin, double ymax ) const;
+
+  //! sum over a rectangle, from bin1 included to bin2 excluded along each axis
+  double Rectangle( const std::vector<double>& sums, const std::vector<double>& compensations, int binx1, int binx2, int biny1, int biny2 ) const
+  {
+    const int i11 = biny1*fStride + binx1;
+    const int i12 = biny2*fStride + binx1;
+    const int i21 = biny1*fStride + binx2;
+    const int i22 = biny2*fStride + binx2;
+    return
+      ( ( sums[i22] - sums[i12] ) - ( sums[i21] - sums[i11] ) ) +
+      ( ( compensations[i22] - compensations[i12] ) - ( compensations[i21] - compensations[i11] ) );
+  }
+
+  //! x axis binning
+  HistogramIntegral::Binning fXBinning;
+
+  //! y axis binning
+  HistogramIntegral::Binning fYBinning;
+
+  //! number of bins along x
+  int fNBinsX;
+
+  //! number of bins along y
+  int fNBinsY;
+
+  //! distance between consecutive rows in tables
+  int fStride;
+
+  //! cumulative contents. Element (i, j) is the sum over cells [0, i-1] x [0, j-1]
+  std::vector<double> fContents;
+
+  //! cumulative contents compensation
+  std::vector<double> fContentCompensations;
+
+  //! cumulative squared errors
+  std::vector<double> fVariances;
+
+  //! cumulative squared errors compensation
+  std::vector<double> fVarianceCompensations;
+
+};
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef HistogramView_h
+#define HistogramView_h
+
+/*!
+\file    HistogramView.h
+\brief   non owning view on histogram contents and squared errors
+*/
+
+#include <TH1.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+#include <TProfile3D.h>
+
+#ifndef __CINT__
+#include <cmath>
+#include <type_traits>
+#endif
+
+/*!
+\class   HistogramView
+\brief   non owning view on histogram contents and squared errors
+
+A view holds the histogram axes and pointers to its content storage (TArrayD or TArrayF,
+selected by the template argument) and to its Sumw2 array, when present. Creating a view
+allocates nothing and registers nothing in gROOT, so that it can be used in place of a
+temporary clone. A view is invalid if the histogram storage does not match its type, and
+for profiles, whose storage holds sums rather than bin contents.
+
+Const views (HistogramView<const double>) read from a const histogram. Mutable views
+also provide transforms that write in place, with no allocation, into the histogram
+they look at. Transforms require both views to have the same number of cells along
+each axis, and return false otherwise. Statistics of the modified histogram are not
+updated.
+
+Views are invalidated by any operation that reallocates the histogram storage, such as
+Rebin, SetBins or the first call to Sumw2.
+*/
+#ifndef __CINT__
+template<class T> class HistogramView
+{
+
+  public:
+
+  //! content type
+  typedef typename std::remove_const<T>::type value_type;
+
+  //! histogram type
+  typedef typename std::conditional<std::is_const<T>::value, const TH1, TH1>::type histogram_type;
+
+  //! squared error type
+  typedef typename std::conditional<std::is_const<T>::value, const double, double>::type variance_type;
+
+  //! array storage type
+  typedef typename std::conditional<std::is_same<value_type, double>::value, TArrayD, TArrayF>::type array_type;
+
+  //! array storage type, with matching constness
+  typedef typename std::conditional<std::is_const<T>::value, const array_type, array_type>::type storage_type;
+
+  //! default constructor. View is invalid
+  HistogramView( void ):
+    fHistogram( 0 ),
+    fNX( 0 ),
+    fNY( 0 ),
+    fNZ( 0 ),
+    fContents( 0 ),
+    fVariances( 0 )
+  {}
+
+  //! constructor
+  explicit HistogramView( histogram_type* h ):
+    fHistogram( 0 ),
+    fNX( 0 ),
+    fNY( 0 ),
+    fNZ( 0 ),
+    fContents( 0 ),
+    fVariances( 0 )
+  {
+    storage_type* array = h ? dynamic_cast<storage_type*>( h ):0;
+    if( !array ) return;
+
+    if( h->InheritsFrom( TProfile::Class() ) || h->InheritsFrom( TProfile2D::Class() ) || h->InheritsFrom( TProfile3D::Class() ) )
+    { return; }
+
+    fHistogram = h;
+    fNX = h->GetNbinsX()+2;
+    fNY = h->GetDimension() > 1 ? h->GetNbinsY()+2:1;
+    fNZ = h->GetDimension() > 2 ? h->GetNbinsZ()+2:1;
+    fContents = array->GetArray();
+    if( h->GetSumw2N() ) fVariances = h->GetSumw2()->GetArray();
+  }
+
+  //! true if view points to a histogram
+  bool IsValid( void ) const
+  { return fContents; }
+
+  //! histogram
+  histogram_type* GetHistogram( void ) const
+  { return fHistogram; }
+
+  //! number of cells, including under and overflow
+  int GetNcells( void ) const
+  { return fNX*fNY*fNZ; }
+
+  //! number of bins along x
+  int GetNbinsX( void ) const
+  { return fNX-2; }
+
+  //! number of bins along y
+  int GetNbinsY( void ) const
+  { return fNY > 1 ? fNY-2:1; }
+
+  //! number of bins along z
+  int GetNbinsZ( void ) const
+  { return fNZ > 1 ? fNZ-2:1; }
+
+  //! global bin, as in TH1::GetBin
+  int GetBin( int binx, int biny = 0, int binz = 0 ) const
+  { return binx + fNX*( biny + fNY*binz ); }
+
+  //! contents
+  T* GetContents( void ) const
+  { return fContents; }
+
+  //! squared errors. Null if the histogram has no Sumw2
+  variance_type* GetVariances( void ) const
+  { return fVariances; }
+
+  //! bin content
+  value_type GetBinContent( int bin ) const
+  { return fContents[bin]; }
+
+  //! squared bin error. Absolute bin content if the histogram has no Sumw2
+  double GetBinVariance( int bin ) const
+  { return fVariances ? fVariances[bin]:std::abs( double( fContents[bin] ) ); }
+
+  //! bin error
+  double GetBinError( int bin ) const
+  { return std::sqrt( GetBinVariance( bin ) ); }
+
+  //! sum of contents over all cells
+  double Integral( void ) const
+  {
+    double out = 0;
+    for( int bin = 0; bin < GetNcells(); ++bin ) out += fContents[bin];
+    return out;
+  }
+
+  //! true if other view has the same number of cells along each axis
+  template<class U> bool Matches( const HistogramView<U>& other ) const
+  { return IsValid() && other.IsValid() && fNX == other.fNX && fNY == other.fNY && fNZ == other.fNZ; }
+
+  //! scale contents, and errors accordingly
+  void Scale( double factor )
+  {
+    for( int bin = 0; bin < GetNcells(); ++bin ) fContents[bin] *= factor;
+    if( fVariances )
+    {
+      const double factor2 = factor*factor;
+      for( int bin = 0; bin < GetNcells(); ++bin ) fVariances[bin] *= factor2;
+    }
+  }
+
+  //! copy contents and squared errors from source
+  template<class U> bool Assign( const HistogramView<U>& source )
+  {
+    if( !Matches( source ) ) return false;
+    for( int bin = 0; bin < GetNcells(); ++bin ) fContents[bin] = source.fContents[bin];
+    if( fVariances )
+    { for( int bin = 0; bin < GetNcells(); ++bin ) fVariances[bin] = source.GetBinVariance( bin ); }
+    return true;
+  }
+
+  //! copy contents and squared errors from source, mirrored along x, under and overflow included
+  template<class U> bool AssignMirrored( const HistogramView<U>& source )
+  {
+    if( !Matches( source ) ) return false;
+    for( int row = 0; row < fNY*fNZ; ++row )
+    {
+      const int first = row*fNX;
+      const int last = first + fNX - 1;
+      for( int i = 0; i < fNX; ++i ) fContents[first+i] = source.fContents[last-i];
+      if( fVariances )
+      { for( int i = 0; i < fNX; ++i ) fVariances[first+i] = source.GetBinVariance( last-i ); }
+    }
+    return true;
+  }
+
+  //! add source contents multiplied by factor, and squared errors accordingly
+  template<class U> bool Add( const HistogramView<U>& source, double factor = 1 )
+  {
+    if( !Matches( source ) ) return false;
+    for( int bin = 0; bin < GetNcells(); ++bin ) fContents[bin] += factor*source.fContents[bin];
+    if( fVariances )
+    {
+      const double factor2 = factor*factor;
+      for( int bin = 0; bin < GetNcells(); ++bin ) fVariances[bin] += factor2*source.GetBinVariance( bin );
+    }
+    return true;
+  }
+
+  private:
+
+  //! views of other types access storage directly
+  template<class U> friend class HistogramView;
+
+  //! histogram
+  histogram_type* fHistogram;
+
+  //! number of cells along x, including under and overflow
+  int fNX;
+
+  //! number of cells along y, including under and overflow
+  int fNY;
+
+  //! number of cells along z, including under and overflow
+  int fNZ;
+
+  //! contents
+  T* fContents;
+
+  //! squared errors
+  variance_type* fVariances;
+
+};
+#endif
+
+#endif
@@ -1,10 +1,15 @@
 #include "LikelihoodFitter.h"
+#include "BinIndex.h"
+#include "FitMonitor.h"
 
 #include <TH1.h>
 #include <TF1.h>
 #include <TMath.h>
 #include <TVirtualFitter.h>
 
+//_______________________________________________________________________________
+const BinIndex* LikelihoodFitter::fBinIndex = 0;
+
 //_______________________________________________________________________________
 // new implementation
 void LikelihoodFitter::Fcn(
@@ -15,6 +20,10 @@ double* u,
 int flag )
 {
 
+    // performance monitoring
+    const bool monitor( FitMonitor::IsEnabled() );
+    const double start( monitor ? FitMonitor::GetTime():0 );
+
     // number of fitted points
     int nFitPoints = 0;
 
@@ -27,9 +36,7 @@ int flag )
     // function used for the fit
     TF1* function = (TF1*)virtualFitter->GetUserFunc();
 
-    // store arguments and number of parameters
-    double x[3];
-    function->InitArgs(x,u);
+    // store number of parameters
     npar = function->GetNpar();
 
     // initialization (copied from root)
@@ -40,8 +47,28 @@ int flag )
 
     }
 
+    // use active bins if available
+    out = ( fBinIndex && fBinIndex->GetHistogram() == histogram ) ?
+        LogLikelihood( *fBinIndex, function, u, nFitPoints ):
+        LogLikelihood( histogram, function, u, nFitPoints );
+    function->SetNumberFitPoints( nFitPoints );
+
+    if( monitor ) FitMonitor::AddFcnCall( FitMonitor::GetTime() - start );
+    return;
+
+}
+
+//_______________________________________________________________________________
+double LikelihoodFitter::LogLikelihood( TH1* histogram, TF1* function, double* u, int& nFitPoints )
+{
+
+    // store arguments
+    double x[3];
+    function->InitArgs(x,u);
+
     // initialize output
-    out = 0;
+    double out = 0;
+    nFitPoints = 0;
 
     // loop over all bins
     for( int binX = histogram->GetXaxis()->GetFirst(); binX <= histogram->GetXaxis()->GetLast(); ++binX )
@@ -72,8 +99,40 @@ int flag )
 
     }
 
-    out *= 2;
-    function->SetNumberFitPoints( nFitPoints );
-    return;
+    return 2*out;
+
+}
+
+//_______________________________________________________________________________
+double LikelihoodFitter::LogLikelihood( const BinIndex& index, TF1* function, double* u, int& nFitPoints )
+{
+
+    // store arguments
+    double x[3];
+    function->InitArgs(x,u);
+
+    // initialize output
+    double out = 0;
+    nFitPoints = 0;
+
+    // loop over active bins
+    for( const auto& entry:index.GetEntries() )
+    {
+
+        // evaluate prediction
+        TF1::RejectPoint(false);
+        const double predicted( TMath::Max( function->EvalPar( entry.fX, u ), 1e-9 ) );
+        if( TF1::RejectedPoint() ) continue;
+
+        // increment fit points and fcn
+        nFitPoints++;
+
+        // calculate log of poissonian probability to get measured, if predicted is the mean
+        const double measured( entry.fContent );
+        out -= ( measured*TMath::Log(predicted) - predicted + TMath::LnGamma( measured+1 ) );
+
+    }
+
+    return 2*out;
 
 }
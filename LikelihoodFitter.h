@@ -1,6 +1,10 @@
 #ifndef LikelihoodFitter_h
 #define LikelihoodFitter_h
 
+class BinIndex;
+class TF1;
+class TH1;
+
 //! log likelihood fitter
 class LikelihoodFitter
 {
@@ -15,6 +19,22 @@ class LikelihoodFitter
     double* u,
     int flag );
 
+  /// -2 log likelihood for a given set of parameters. Also returns the number of fitted points
+  static double LogLikelihood( TH1*, TF1*, double* u, int& nFitPoints );
+
+  /// -2 log likelihood over active bins for a given set of parameters. Also returns the number of fitted points
+  /// Points are rejected using the global TF1::RejectPoint flag: concurrent calls require functions that never reject points
+  static double LogLikelihood( const BinIndex&, TF1*, double* u, int& nFitPoints );
+
+  /// active bins used by Fcn, if built from the fitted histogram
+  static void SetBinIndex( const BinIndex* index )
+  { fBinIndex = index; }
+
+  private:
+
+  /// active bins
+  static const BinIndex* fBinIndex;
+
 };
 
 #endif
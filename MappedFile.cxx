@@ -0,0 +1,95 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+
+/*!
+  \file MappedFile.cxx
+  \brief read only memory mapped file
+*/
+
+//__________________________________________________________________
+MappedFile::MappedFile( const char* filename ):
+  fValid( false ),
+  fMapped( false ),
+  fData( 0 ),
+  fSize( 0 )
+{
+
+  const int descriptor = filename ? open( filename, O_RDONLY ):-1;
+  if( descriptor < 0 ) return;
+
+  struct stat status;
+  if( fstat( descriptor, &status ) == 0 && S_ISREG( status.st_mode ) )
+  {
+
+    fSize = status.st_size;
+    fValid = true;
+
+    if( fSize > 0 )
+    {
+      void* data = mmap( 0, fSize, PROT_READ, MAP_PRIVATE, descriptor, 0 );
+      if( data != MAP_FAILED )
+      {
+        madvise( data, fSize, MADV_SEQUENTIAL );
+        fData = static_cast<const char*>( data );
+        fMapped = true;
+      }
+    }
+
+  }
+
+  if( fValid && ( fMapped || !fSize ) )
+  {
+    close( descriptor );
+    return;
+  }
+
+  // could not map. Read into buffer
+  size_t capacity = 1<<16;
+  size_t size = 0;
+  char* buffer = new char[capacity];
+  while( true )
+  {
+
+    if( size == capacity )
+    {
+      char* tmp = new char[2*capacity];
+      memcpy( tmp, buffer, size );
+      delete[] buffer;
+      buffer = tmp;
+      capacity *= 2;
+    }
+
+    const ssize_t count = read( descriptor, buffer + size, capacity - size );
+    if( count < 0 )
+    {
+      std::cout << "MappedFile::MappedFile - error reading " << filename << std::endl;
+      delete[] buffer;
+      close( descriptor );
+      fValid = false;
+      fSize = 0;
+      return;
+    } else if( count == 0 ) break;
+    else size += count;
+
+  }
+
+  close( descriptor );
+  fData = buffer;
+  fSize = size;
+  fValid = true;
+
+}
+
+//__________________________________________________________________
+MappedFile::~MappedFile( void )
+{
+  if( fMapped ) munmap( const_cast<char*>( fData ), fSize );
+  else delete[] fData;
+}
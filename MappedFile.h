@@ -0,0 +1,69 @@
+#ifndef MappedFile_h
+#define MappedFile_h
+
+/*!
+\file    MappedFile.h
+\brief   read only memory mapped file
+*/
+
+#include <cstddef>
+
+/*!
+\class   MappedFile
+\brief   read only memory mapped file
+
+The file is mapped on construction and unmapped on destruction. Contents are accessed
+in place, with no copy. When the file cannot be mapped, for instance for pipes or
+special files, it is read into an owned buffer instead. Empty files are valid, with
+zero size.
+*/
+class MappedFile
+{
+
+  public:
+
+  //! constructor
+  MappedFile( const char* filename );
+
+  //! destructor
+  ~MappedFile( void );
+
+  //! true if file could be opened
+  bool IsValid( void ) const
+  { return fValid; }
+
+  //! file contents
+  const char* GetData( void ) const
+  { return fData; }
+
+  //! file size
+  size_t GetSize( void ) const
+  { return fSize; }
+
+  //! end of file contents
+  const char* GetEnd( void ) const
+  { return fData + fSize; }
+
+  private:
+
+  //! copy is not allowed
+  MappedFile( const MappedFile& );
+
+  //! assignment is not allowed
+  MappedFile& operator = ( const MappedFile& );
+
+  //! true if file could be opened
+  bool fValid;
+
+  //! true if data is mapped, false if owned
+  bool fMapped;
+
+  //! contents
+  const char* fData;
+
+  //! size
+  size_t fSize;
+
+};
+
+#endif
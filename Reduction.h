@@ -0,0 +1,258 @@
+#ifndef Reduction_h
+#define Reduction_h
+
+/*!
+\file    Reduction.h
+\brief   accurate summation and moments of arrays
+*/
+
+#ifndef __CINT__
+#include <limits>
+#endif
+
+/*!
+\class   Reduction
+\brief   accurate summation and moments of arrays
+
+Sums are compensated: the rounding error of each addition is recovered exactly
+(TwoSum, branch free) and accumulated separately, so that the error does not grow
+with the number of elements. Array loops run over fLanes independent accumulators,
+which breaks the dependency chain between consecutive additions and lets the
+compiler keep them in vector registers. Lanes are combined at the end.
+
+Mean and variance are computed in one pass, using Welford (West for weighted
+values) updates in each lane, combined with the parallel formula of Chan et al.
+*/
+class Reduction
+{
+
+  public:
+
+  #ifndef __CINT__
+
+  //! number of independent accumulators used in array loops
+  enum { fLanes = 8 };
+
+  //! compensated accumulator
+  class Accumulator
+  {
+    public:
+
+    //! constructor
+    Accumulator( void ):
+      fSum( 0 ),
+      fCompensation( 0 )
+    {}
+
+    //! add value
+    void Add( double value )
+    { TwoSum( fSum, fCompensation, value ); }
+
+    //! add other accumulator
+    void Add( const Accumulator& other )
+    {
+      Add( other.fSum );
+      Add( other.fCompensation );
+    }
+
+    //! compensated sum
+    double Get( void ) const
+    { return fSum + fCompensation; }
+
+    //! running sum, without compensation
+    double GetSum( void ) const
+    { return fSum; }
+
+    //! running compensation
+    double GetCompensation( void ) const
+    { return fCompensation; }
+
+    private:
+
+    //! running sum
+    double fSum;
+
+    //! running compensation
+    double fCompensation;
+  };
+
+  //! running mean and variance
+  class Moments
+  {
+    public:
+
+    //! constructor
+    Moments( void ):
+      fWeight( 0 ),
+      fMean( 0 ),
+      fSum2( 0 )
+    {}
+
+    //! add value with weight
+    void Add( double value, double weight = 1 )
+    {
+      fWeight += weight;
+      const double delta = value - fMean;
+      fMean += delta*weight/fWeight;
+      fSum2 += weight*delta*( value - fMean );
+    }
+
+    //! merge other moments
+    void Add( const Moments& other )
+    {
+      if( !other.fWeight ) return;
+      if( !fWeight ) { *this = other; return; }
+
+      const double weight = fWeight + other.fWeight;
+      const double delta = other.fMean - fMean;
+      fMean += delta*other.fWeight/weight;
+      fSum2 += other.fSum2 + delta*delta*fWeight*other.fWeight/weight;
+      fWeight = weight;
+    }
+
+    //! sum of weights
+    double GetWeight( void ) const
+    { return fWeight; }
+
+    //! mean. NaN if empty
+    double GetMean( void ) const
+    { return fWeight ? fMean:std::numeric_limits<double>::quiet_NaN(); }
+
+    //! variance, normalized to the sum of weights. NaN if empty
+    double GetVariance( void ) const
+    { return fWeight ? fSum2/fWeight:std::numeric_limits<double>::quiet_NaN(); }
+
+    private:
+
+    //! sum of weights
+    double fWeight;
+
+    //! mean
+    double fMean;
+
+    //! sum of weighted squared deviations to the mean
+    double fSum2;
+  };
+
+  //! compensated sum
+  static double Sum( const double* values, int n )
+  {
+    double sums[fLanes] = { 0 };
+    double compensations[fLanes] = { 0 };
+    const int nMain = n - n%fLanes;
+    for( int i = 0; i < nMain; i += fLanes )
+      for( int lane = 0; lane < fLanes; ++lane )
+    { TwoSum( sums[lane], compensations[lane], values[i+lane] ); }
+
+    for( int i = nMain; i < n; ++i ) TwoSum( sums[0], compensations[0], values[i] );
+    return Combine( sums, compensations );
+  }
+
+  //! compensated sum of squares
+  static double SumSquares( const double* values, int n )
+  {
+    double sums[fLanes] = { 0 };
+    double compensations[fLanes] = { 0 };
+    const int nMain = n - n%fLanes;
+    for( int i = 0; i < nMain; i += fLanes )
+      for( int lane = 0; lane < fLanes; ++lane )
+    { TwoSum( sums[lane], compensations[lane], values[i+lane]*values[i+lane] ); }
+
+    for( int i = nMain; i < n; ++i ) TwoSum( sums[0], compensations[0], values[i]*values[i] );
+    return Combine( sums, compensations );
+  }
+
+  /*!
+  pairwise sum. Blocks of fBlockSize elements are summed with plain lane
+  accumulators, blocks are combined recursively. Error grows as log(n)
+  */
+  static double PairwiseSum( const double* values, int n )
+  {
+    if( n <= fBlockSize )
+    {
+      double lanes[fLanes] = { 0 };
+      const int nMain = n - n%fLanes;
+      for( int i = 0; i < nMain; i += fLanes )
+        for( int lane = 0; lane < fLanes; ++lane )
+      { lanes[lane] += values[i+lane]; }
+
+      for( int i = nMain; i < n; ++i ) lanes[0] += values[i];
+      for( int width = fLanes/2; width > 0; width /= 2 )
+        for( int lane = 0; lane < width; ++lane )
+      { lanes[lane] += lanes[lane+width]; }
+
+      return lanes[0];
+    }
+
+    // split on a multiple of the block size
+    const int half = fBlockSize*( ( n/fBlockSize + 1 )/2 );
+    return PairwiseSum( values, half ) + PairwiseSum( values + half, n - half );
+  }
+
+  //! one pass mean and variance
+  static Moments GetMoments( const double* values, int n )
+  {
+    Moments lanes[fLanes];
+    const int nMain = n - n%fLanes;
+    for( int i = 0; i < nMain; i += fLanes )
+      for( int lane = 0; lane < fLanes; ++lane )
+    { lanes[lane].Add( values[i+lane] ); }
+
+    for( int i = nMain; i < n; ++i ) lanes[0].Add( values[i] );
+    return Combine( lanes );
+  }
+
+  //! one pass mean and variance of values weighted by 1/error^2. Values with non positive errors are skipped
+  static Moments GetMoments( const double* values, const double* errors, int n )
+  {
+    Moments lanes[fLanes];
+    const int nMain = n - n%fLanes;
+    for( int i = 0; i < nMain; i += fLanes )
+      for( int lane = 0; lane < fLanes; ++lane )
+    {
+      const double error = errors[i+lane];
+      if( error > 0 ) lanes[lane].Add( values[i+lane], 1.0/( error*error ) );
+    }
+
+    for( int i = nMain; i < n; ++i )
+    { if( errors[i] > 0 ) lanes[0].Add( values[i], 1.0/( errors[i]*errors[i] ) ); }
+
+    return Combine( lanes );
+  }
+
+  private:
+
+  //! block size for pairwise summation
+  enum { fBlockSize = 128 };
+
+  //! add value to sum, accumulating the exact rounding error in compensation
+  static void TwoSum( double& sum, double& compensation, double value )
+  {
+    const double out = sum + value;
+    const double delta = out - sum;
+    compensation += ( sum - ( out - delta ) ) + ( value - delta );
+    sum = out;
+  }
+
+  //! combine lanes
+  template<class T> static T Combine( const T* lanes )
+  {
+    T out( lanes[0] );
+    for( int lane = 1; lane < fLanes; ++lane ) out.Add( lanes[lane] );
+    return out;
+  }
+
+  //! combine lanes
+  static double Combine( const double* sums, const double* compensations )
+  {
+    Accumulator out;
+    for( int lane = 0; lane < fLanes; ++lane ) out.Add( sums[lane] );
+    for( int lane = 0; lane < fLanes; ++lane ) out.Add( compensations[lane] );
+    return out.Get();
+  }
+
+  #endif
+
+};
+
+#endif
@@ -0,0 +1,239 @@
+#include "SimultaneousFitter.h"
+#include "ChisquareFitter.h"
+#include "LikelihoodFitter.h"
+#include "WorkerPool.h"
+
+#include <TF1.h>
+#include <TH1.h>
+#include <TMath.h>
+#include <TMinuit.h>
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+
+/*!
+  \file SimultaneousFitter.cxx
+  \brief simultaneous fit of several histograms, with parameters shared by name
+*/
+
+//__________________________________
+SimultaneousFitter* SimultaneousFitter::fCurrent = 0;
+
+//__________________________________
+const int SimultaneousFitter::fMinBinsPerWorker = 1000;
+
+//___________________________
+SimultaneousFitter::~SimultaneousFitter( void )
+{ if( fCurrent == this ) fCurrent = 0; }
+
+//__________________________________________________________________
+int SimultaneousFitter::GetParameterIndex( const TString& name ) const
+{
+  for( unsigned int i = 0; i < fNames.size(); ++i )
+  { if( fNames[i] == name ) return i; }
+  return -1;
+}
+
+//__________________________________________________________________
+void SimultaneousFitter::Add( TH1* h, TF1* f )
+{
+
+  if( !( h && f ) )
+  {
+    std::cout << "SimultaneousFitter::Add - histogram or function not set" << std::endl;
+    return;
+  }
+
+  Entry entry;
+  entry.fHistogram = h;
+  entry.fFunction = f;
+  entry.fFcn = 0;
+  entry.fNFitPoints = 0;
+
+  for( int iP = 0; iP < f->GetNpar(); ++iP )
+  {
+
+    const TString name( f->GetParName( iP ) );
+    int index = GetParameterIndex( name );
+    if( index < 0 )
+    {
+      // new parameter
+      index = fNames.size();
+      fNames.push_back( name );
+      fValues.push_back( f->GetParameter( iP ) );
+      fErrors.push_back( f->GetParError( iP ) );
+
+      double min = 0;
+      double max = 0;
+      f->GetParLimits( iP, min, max );
+      fMin.push_back( min );
+      fMax.push_back( max );
+    }
+
+    entry.fIndex.push_back( index );
+    entry.fParameters.push_back( fValues[index] );
+
+  }
+
+  fEntries.push_back( entry );
+
+}
+
+//__________________________________________________________________
+int SimultaneousFitter::Fit( void )
+{
+
+  if( fEntries.empty() )
+  {
+    std::cout << "SimultaneousFitter::Fit - nothing to fit" << std::endl;
+    return -1;
+  }
+
+  std::cout << "SimultaneousFitter::Fit - histograms: " << fEntries.size() << " parameters: " << fNames.size() << std::endl;
+
+  // active bins
+  const bool likelihood( fOption.Contains( "L" ) );
+  for( auto& entry:fEntries )
+  { entry.fBins.Build( entry.fHistogram, entry.fFunction, !likelihood ); }
+
+  const int nPar = fNames.size();
+  TMinuit minuit( nPar );
+  minuit.SetPrintLevel( -1 );
+
+  // errors correspond to one unit of chisquare or -2 log(L)
+  int error = 0;
+  double arglist[2] = { 1, 0 };
+  minuit.mnexcm( "SET ERR", arglist, 1, error );
+
+  for( int iP = 0; iP < nPar; ++iP )
+  {
+
+    double step = fErrors[iP];
+    if( step <= 0 ) step = fValues[iP] ? 0.1*TMath::Abs( fValues[iP] ):0.1;
+
+    double min = fMin[iP];
+    double max = fMax[iP];
+    const bool fixed( min*max != 0 && min >= max );
+    if( fixed || min >= max ) { min = 0; max = 0; }
+
+    minuit.mnparm( iP, fNames[iP], fValues[iP], step, min, max, error );
+    if( error ) std::cout << "SimultaneousFitter::Fit - ERROR: Troubles defining parameter " << fNames[iP] << std::endl;
+
+    if( fixed )
+    {
+      arglist[0] = iP+1;
+      minuit.mnexcm( "FIX", arglist, 1, error );
+    }
+
+  }
+
+  // persistent workers for parallel evaluation, if allowed
+  const unsigned int nWorkers = GetNWorkers();
+  WorkerPool pool( nWorkers );
+  if( nWorkers > 1 ) fPool = &pool;
+
+  std::cout << "SimultaneousFitter::Fit - workers: " << nWorkers << std::endl;
+
+  // minimize
+  fCurrent = this;
+  minuit.SetFCN( Fcn );
+
+  arglist[0] = 5000;
+  minuit.mnexcm( "MIGRAD", arglist, 1, error );
+  const int status = error;
+  if( !status ) minuit.mnexcm( "HESSE", arglist, 1, error );
+  fCurrent = 0;
+  fPool = 0;
+
+  // store shared parameters
+  for( int iP = 0; iP < nPar; ++iP )
+  { minuit.GetParameter( iP, fValues[iP], fErrors[iP] ); }
+
+  // evaluate contributions at minimum and store in functions
+  fFcn = Evaluate( &fValues[0] );
+  for( auto& entry:fEntries )
+  {
+    for( unsigned int iP = 0; iP < entry.fIndex.size(); ++iP )
+    {
+      entry.fFunction->SetParameter( iP, fValues[entry.fIndex[iP]] );
+      entry.fFunction->SetParError( iP, fErrors[entry.fIndex[iP]] );
+    }
+
+    entry.fFunction->SetChisquare( entry.fFcn );
+    entry.fFunction->SetNumberFitPoints( entry.fNFitPoints );
+  }
+
+  return status;
+
+}
+
+//__________________________________________________________________
+unsigned int SimultaneousFitter::GetNWorkers( void ) const
+{
+
+  // functions can only be evaluated in parallel if they are all distinct
+  std::set<TF1*> functions;
+  for( const auto& entry:fEntries ) functions.insert( entry.fFunction );
+  if( functions.size() != fEntries.size() ) return 1;
+
+  // TF1::RejectPoint uses a global flag, shared by all threads. Functions defined from a formula never set it
+  if( fRejectPoints )
+  {
+    for( const auto& entry:fEntries )
+    { if( !entry.fFunction->GetFormula() ) return 1; }
+  }
+
+  // thread synchronization costs more than evaluating a few bins
+  int nBins = 0;
+  for( const auto& entry:fEntries ) nBins += entry.fBins.GetSize();
+  const unsigned int nTasks = std::min<unsigned int>( fEntries.size(), nBins/fMinBinsPerWorker );
+
+  return WorkerPool::GetNWorkers( fNWorkers, nTasks );
+
+}
+
+//__________________________________________________________________
+double SimultaneousFitter::Evaluate( const double* par )
+{
+
+  const bool likelihood( fOption.Contains( "L" ) );
+
+  const WorkerPool::Function function(
+    [&]( unsigned int, unsigned int first, unsigned int end )
+    {
+      for( unsigned int i = first; i < end; ++i )
+      {
+        Entry& entry( fEntries[i] );
+        for( unsigned int iP = 0; iP < entry.fIndex.size(); ++iP )
+        { entry.fParameters[iP] = par[entry.fIndex[iP]]; }
+
+        entry.fFcn = likelihood ?
+          LikelihoodFitter::LogLikelihood( entry.fBins, entry.fFunction, &entry.fParameters[0], entry.fNFitPoints ):
+          ChisquareFitter::Chisquare( entry.fBins, entry.fFunction, &entry.fParameters[0], entry.fNFitPoints );
+      }
+    } );
+
+  if( fPool ) fPool->Execute( fEntries.size(), function );
+  else function( 0, 0, fEntries.size() );
+
+  // sum in fixed order, so that the result does not depend on the number of workers
+  double out = 0;
+  for( const auto& entry:fEntries ) out += entry.fFcn;
+  return out;
+
+}
+
+//_____________________________________________________
+void SimultaneousFitter::Fcn( int& npar, double *gin, double &res, double *par, int flag )
+{
+
+  if( !fCurrent ) {
+    std::cout << "SimultaneousFitter::Fcn - FATAL: fitter not set" << std::endl;
+    return;
+  }
+
+  res = fCurrent->Evaluate( par );
+  return;
+
+}
@@ -0,0 +1,172 @@
+#ifndef SimultaneousFitter_h
+#define SimultaneousFitter_h
+
+/*!
+\file    SimultaneousFitter.h
+\brief   simultaneous fit of several histograms, with parameters shared by name
+*/
+
+#include "BinIndex.h"
+
+#include <TROOT.h>
+#include <TObject.h>
+#include <TString.h>
+
+#include <vector>
+
+class TF1;
+class TH1;
+class WorkerPool;
+
+/*!
+\class   SimultaneousFitter
+\brief   simultaneous fit of several histograms, with parameters shared by name
+
+Each histogram is fitted with its own function. Function parameters with the same
+name are shared across functions. The total chisquare (or -2 log likelihood, with
+option "L") is the sum of the per histogram contributions, calculated with the local
+ChisquareFitter and LikelihoodFitter.
+
+Contributions are evaluated in parallel, on workers kept alive for the whole fit,
+when all functions are distinct objects, when there are enough active bins for
+each worker, and when no function can reject points: TF1::RejectPoint uses a global
+flag, shared by all threads. Functions defined from a formula never reject points.
+Other functions are assumed to, unless SetRejectPoints( false ) is called.
+*/
+class SimultaneousFitter
+{
+
+  public:
+
+  //! constructor
+  SimultaneousFitter( TString option = "" ):
+    fOption( option ),
+    fNWorkers( 0 ),
+    fRejectPoints( true ),
+    fFcn( 0 ),
+    fPool( 0 )
+  {}
+
+  //! destructor
+  virtual ~SimultaneousFitter( void );
+
+  //! number of workers. Zero means one per hardware thread
+  void SetNWorkers( unsigned int value )
+  { fNWorkers = value; }
+
+  //! true if functions not defined from a formula may call TF1::RejectPoint, which prevents parallel evaluation
+  void SetRejectPoints( bool value )
+  { fRejectPoints = value; }
+
+  /*!
+  add histogram and function. New parameters are initialized from the function,
+  parameters that already exist are shared
+  */
+  void Add( TH1* h, TF1* f );
+
+  //! fit. Returns minuit status
+  int Fit( void );
+
+  //! number of shared parameters
+  int GetNParameters( void ) const
+  { return fNames.size(); }
+
+  //! parameter index from name, -1 if not found
+  int GetParameterIndex( const TString& name ) const;
+
+  //! parameter name
+  const TString& GetParameterName( int i ) const
+  { return fNames[i]; }
+
+  //! parameter value
+  double GetParameter( int i ) const
+  { return fValues[i]; }
+
+  //! parameter error
+  double GetParError( int i ) const
+  { return fErrors[i]; }
+
+  //! total chisquare or -2 log likelihood at minimum
+  double GetFcn( void ) const
+  { return fFcn; }
+
+  private:
+
+  //! minuit function
+  static void Fcn( int& npar, double *gin, double &res, double *par, int flag );
+
+  //! number of workers used for evaluation
+  unsigned int GetNWorkers( void ) const;
+
+  //! sum of all contributions for a given set of shared parameters
+  double Evaluate( const double* par );
+
+  //! one histogram and its function
+  class Entry
+  {
+    public:
+
+    //! histogram
+    TH1* fHistogram;
+
+    //! function
+    TF1* fFunction;
+
+    //! active bins
+    BinIndex fBins;
+
+    //! shared parameter index for each function parameter
+    std::vector<int> fIndex;
+
+    //! function parameters
+    std::vector<double> fParameters;
+
+    //! contribution to fcn
+    double fFcn;
+
+    //! number of fitted points
+    int fNFitPoints;
+  };
+
+  //! fit option
+  TString fOption;
+
+  //! number of workers
+  unsigned int fNWorkers;
+
+  //! true if functions may reject points
+  bool fRejectPoints;
+
+  //! histograms and functions
+  std::vector<Entry> fEntries;
+
+  //! shared parameter names
+  std::vector<TString> fNames;
+
+  //! shared parameter values
+  std::vector<double> fValues;
+
+  //! shared parameter errors
+  std::vector<double> fErrors;
+
+  //! shared parameter lower limits
+  std::vector<double> fMin;
+
+  //! shared parameter upper limits
+  std::vector<double> fMax;
+
+  //! fcn at minimum
+  double fFcn;
+
+  //! persistent workers, during minimization
+  WorkerPool* fPool;
+
+  //! minimum number of active bins per worker
+  static const int fMinBinsPerWorker;
+
+  //! fitter being minimized, used by static minuit function
+  static SimultaneousFitter* fCurrent;
+
+};
+
+#endif
@@ -23,6 +23,9 @@ unsigned int TH2Fit::fNParametersStatic = 0;
 double TH2Fit::fXMin = 1;
 double TH2Fit::fXMax = -1;
 
+std::vector<TH2Fit::Moments> TH2Fit::fMomentsStatic;
+double TH2Fit::fSumStatic = 0;
+
 
 //___________________________
 TH2Fit::TH2Fit( TF1* f, const unsigned int nP ):
@@ -73,6 +76,9 @@ bool TH2Fit::Fit( TH2* h, const double xMin, const double xMax )
 		fXMax = xMax;
 	}
 
+	// collapse histogram into per column moments
+	FillMoments( false );
+
 	// set Minuit minimisation function
 	gMinuit->SetFCN(Fcn);
 
@@ -106,6 +112,9 @@ bool TH2Fit::FitInverted( TH2* h, const double yMin, const double yMax	)
 		fXMax = yMax;
 	}
 
+	// collapse histogram into per row moments
+	FillMoments( true );
+
 	// set Minuit minimisation function
 	gMinuit->SetFCN(FcnInv);
 
@@ -120,6 +129,74 @@ bool TH2Fit::FitInverted( TH2* h, const double yMin, const double yMax	)
 	return true;
 }
 
+//_____________________________________________________
+void TH2Fit::FillMoments( bool inverted )
+{
+	fMomentsStatic.clear();
+	fSumStatic = 0;
+
+	const unsigned int nX = fHStatic->GetNbinsX();
+	const unsigned int nY = fHStatic->GetNbinsY();
+
+	// the abscissa runs along x, unless inverted
+	const unsigned int nOuter = inverted ? nY:nX;
+	const unsigned int nInner = inverted ? nX:nY;
+	fMomentsStatic.reserve( nOuter );
+
+	for( unsigned int iOuter = 1; iOuter <= nOuter; iOuter++ )
+	{
+		const double x = inverted ?
+			fHStatic->GetYaxis()->GetBinCenter( iOuter ):
+			fHStatic->GetXaxis()->GetBinCenter( iOuter );
+
+		// warning fXMin and xMax apply to y when inverted
+		if( !( x >= fXMin && x < fXMax ) ) continue;
+
+		// weighted sums. Plain sums, rather than a running mean, keep negative weights valid
+		Moments moments = { x, 0, 0, 0 };
+		bool empty = true;
+		for( unsigned int iInner = 1; iInner <= nInner; iInner++ )
+		{
+			const double n = inverted ?
+				fHStatic->GetBinContent( iInner, iOuter ):
+				fHStatic->GetBinContent( iOuter, iInner );
+			if( n == 0 ) continue;
+
+			const double y = inverted ?
+				fHStatic->GetXaxis()->GetBinCenter( iInner ):
+				fHStatic->GetYaxis()->GetBinCenter( iInner );
+
+			moments.fSum += n;
+			moments.fSumY += n*y;
+			moments.fSumY2 += n*y*y;
+			empty = false;
+		}
+
+		if( empty ) continue;
+		fSumStatic += moments.fSum;
+		fMomentsStatic.push_back( moments );
+	}
+
+	return;
+}
+
+//_____________________________________________________
+double TH2Fit::Evaluate( double *par )
+{
+	for( unsigned int iP = 0; iP < fNParametersStatic; iP++ )
+	fFStatic->SetParameter( iP, par[iP] );
+
+	// sum( n*(y-f(x))^2 ) = sum_x( sum(n*y^2) - 2*f(x)*sum(n*y) + f(x)^2*sum(n) )
+	double res = 0;
+	for( std::vector<Moments>::const_iterator iter = fMomentsStatic.begin(); iter != fMomentsStatic.end(); ++iter )
+	{
+		const double f = fFStatic->Eval( iter->fX );
+		res += iter->fSumY2 - 2*f*iter->fSumY + f*f*iter->fSum;
+	}
+
+	return res/fSumStatic;
+}
+
 //_____________________________________________________
 void TH2Fit::Fcn( int& npar, double *gin, double &res, double *par, int flag )
 {
@@ -128,8 +205,6 @@ void TH2Fit::Fcn( int& npar, double *gin, double &res, double *par, int flag )
 		std::cout << "TH2Fit::Fcn - FATAL: histogram not set" << std::endl;
 		return;
 	}
-	unsigned int nX = fHStatic->GetNbinsX();
-	unsigned int nY = fHStatic->GetNbinsY();
 
 	// Get Function and set parameters
 	if( !fFStatic ) {
@@ -137,24 +212,7 @@ void TH2Fit::Fcn( int& npar, double *gin, double &res, double *par, int flag )
 		return;
 	}
 
-	for( unsigned int iP = 0; iP < fNParametersStatic; iP++ )
-	fFStatic->SetParameter( iP, par[iP] );
-
-	// Scan all bins, calculate result
-	double nEnt = 0;
-	res = 0;
-	for( unsigned int iX = 1; iX <= nX; iX++ )
-	for( unsigned int iY = 1; iY <= nY; iY++ ) {
-		double x = fHStatic->GetXaxis()->GetBinCenter( iX );
-		double y = fHStatic->GetYaxis()->GetBinCenter( iY );
-		double n = fHStatic->GetBinContent( iX, iY );
-		if( x >= fXMin && x < fXMax ) {
-			res+= n* pow( y - fFStatic->Eval( x ), 2 );
-			nEnt+=n;
-		}
-	}
-	res/=nEnt;
-
+	res = Evaluate( par );
 	return;
 }
 
@@ -166,8 +224,6 @@ void TH2Fit::FcnInv( int& npar, double *gin, double &res, double *par, int flag
 		std::cout << "TH2Fit::FcnInv - FATAL: histogram not set" << std::endl;
 		return;
 	}
-	unsigned int nX = fHStatic->GetNbinsX();
-	unsigned int nY = fHStatic->GetNbinsY();
 
 	// Get Function and set parameters
 	if( !fFStatic ) {
@@ -175,24 +231,6 @@ void TH2Fit::FcnInv( int& npar, double *gin, double &res, double *par, int flag
 		return;
 	}
 
-	for( unsigned int iP = 0; iP < fNParametersStatic; iP++ )
-	fFStatic->SetParameter( iP, par[iP] );
-
-	// Scan all bins, calculate result
-	double nEnt = 0;
-	res = 0;
-	for( unsigned int iX = 1; iX <= nX; iX++ )
-	for( unsigned int iY = 1; iY <= nY; iY++ ) {
-		double x = fHStatic->GetXaxis()->GetBinCenter( iX );
-		double y = fHStatic->GetYaxis()->GetBinCenter( iY );
-		double n = fHStatic->GetBinContent( iX, iY );
-
-		// warning fXMin and xMax here apply to y!
-		if( y >= fXMin && y < fXMax ) {
-			res+= n* pow( x - fFStatic->Eval( y, 0, 0 ), 2 );
-			nEnt+=n;
-		}
-	}
-	res/=nEnt;
+	res = Evaluate( par );
 	return;
 }
@@ -12,6 +12,7 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
 #include <TROOT.h>
 #include <TObject.h>
 class TH2;
@@ -67,6 +68,34 @@ class TH2Fit {
   //! minuit to be minimised function (sum (x-f(y))^2 )
   static void FcnInv( int& npar, double *gin, double &res, double *par, int flag );
 
+  /*!
+  \brief collapse the histogram into per-column moments
+  \param inverted if true, moments of x are calculated for each y row
+  */
+  static void FillMoments( bool inverted );
+
+  //! minuit to be minimised function, using precomputed moments
+  static double Evaluate( double *par );
+
+  /*!
+  \struct Moments
+  \brief weighted sums of the fitted coordinate and its square, for a given abscissa
+  */
+  struct Moments
+  {
+    //! abscissa (bin center)
+    double fX;
+
+    //! sum of weights
+    double fSum;
+
+    //! weighted sum of the fitted coordinate
+    double fSumY;
+
+    //! weighted sum of the squared fitted coordinate
+    double fSumY2;
+  };
+
   //! function used for the fit
   TF1* f_;
 
@@ -91,6 +120,12 @@ class TH2Fit {
   //! upper limit for the fit
   static double fXMax;
 
+  //! per column moments, within fit range
+  static std::vector<Moments> fMomentsStatic;
+
+  //! total sum of weights, within fit range
+  static double fSumStatic;
+
 };
 
 
@@ -6,11 +6,17 @@
 */
 
 #include "Table.h"
+#include "BinaryTable.h"
+#include "CsvTable.h"
+#include "TableWriter.h"
+#include "MappedFile.h"
 #include "Stream.h"
+#include "Tokenizer.h"
+#include "WorkerPool.h"
 #include "Utils.h"
 
 #include <algorithm>
-#include <fstream>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -20,256 +26,461 @@ ClassImp( ColumnBase );
 ClassImp( Table );
 
 //_________________________________________________________________
-void Line::Parse( const TString& line_buffering )
+void ColumnDerived::Update( void ) const
 {
 
-  clear();
+  // update sources first, so that derived sources are evaluated and their version is current
+  bool changed = !fEvaluated || fSourceVersions.size() != fSources.size();
+  fSourceVersions.resize( fSources.size() );
+  for( size_t i = 0; i < fSources.size(); i++ )
+  {
+    fSources[i]->Update();
+    changed |= fSourceVersions[i] != fSources[i]->GetVersion();
+    fSourceVersions[i] = fSources[i]->GetVersion();
+  }
+
+  if( !changed ) return;
 
-  std::istringstream in( line_buffering.Data() );
-  while( !(in.rdstate() & std::ios::failbit ) )
+  // source values, with no copy for double columns
+  const int size = Size();
+  std::vector< ColumnSpan<double> > sources;
+  fBuffers.resize( fSources.size() );
+  for( size_t i = 0; i < fSources.size(); i++ )
   {
-    std::string value;
-    in >> value;
-    if( !(in.rdstate() & std::ios::failbit ) ) push_back( value );
+    auto convert = [&]( const auto& values ) -> ColumnSpan<double>
+    {
+      fBuffers[i].assign( values.begin(), values.begin() + size );
+      return ColumnSpan<double>( fBuffers[i].data(), size );
+    };
+
+    const ColumnBase* source = fSources[i];
+    if( const Column<double>* typed = dynamic_cast<const Column<double>*>( source ) ) sources.push_back( ColumnSpan<double>( typed->GetSpan().data(), size ) );
+    else if( const Column<float>* typed = dynamic_cast<const Column<float>*>( source ) ) sources.push_back( convert( typed->GetSpan() ) );
+    else if( const Column<int>* typed = dynamic_cast<const Column<int>*>( source ) ) sources.push_back( convert( typed->GetSpan() ) );
+    else if( const Column<unsigned char>* typed = dynamic_cast<const Column<unsigned char>*>( source ) ) sources.push_back( convert( typed->GetSpan() ) );
+    else {
+      std::cout << "ColumnDerived::Update - column " << source->GetName() << " is not numeric" << std::endl;
+      fBuffers[i].assign( size, 0 );
+      sources.push_back( ColumnSpan<double>( fBuffers[i].data(), size ) );
+    }
   }
 
-  std::cout << "Table::Line::Parse - " << size() << " values read" << std::endl;
+  // values are a cache of the function result, so they are updated from const accessors
+  ColumnDerived* self = const_cast<ColumnDerived*>( this );
+  self->fValues.resize( size );
+  if( size > 0 && fFunction ) fFunction( sources, self->fValues.data(), size );
+  self->Touch();
+  fEvaluated = true;
+
+}
+
+//_________________________________________________________________
+void Line::Parse( const TString& line_buffering )
+{
+
+  clear();
+
+  const char* cursor = line_buffering.Data();
+  const char* end = cursor + line_buffering.Length();
+  const char* tokenBegin;
+  const char* tokenEnd;
+  while( Tokenizer::NextToken( cursor, end, tokenBegin, tokenEnd ) )
+  { push_back( TString( tokenBegin, tokenEnd - tokenBegin ) ); }
+
 }
 
 //_________________________________________________________________
 void Table::AddConversion( const char* c1, const char* c2 )
 { if( c1 && c2 ) fConversions.push_back( ConversionPair( std::string( c1 ), std::string( c2 ) ) ); }
 
-//_________________________________________________________________
-void Table::Load( const char* filename )
+namespace
 {
-  if( !filename ) {
-    std::cout << "Table::load - empty string." << std::endl;
-    return;
-  }
 
-  std::ifstream in( filename );
-  if( !in ) {
-    std::cout << "Table::load - invalid file: " << filename << std::endl;
-    return;
-  }
+  //* number of lines used to detect column types
+  const int nSampleLines = 100;
 
-  // clear columns
-  fColumns.clear();
+  //* minimum number of bytes per chunk, for parallel parsing
+  const size_t minChunkSize = 1<<22;
 
-  // store Parsed lines
-  std::vector< Line > lines;
+  //* conversion pairs
+  typedef std::list< std::pair<TString, TString> > ConversionList;
 
-  char line_buffer[1024];
-  while( in.getline( line_buffer, 1024, '\n' ) )
+  //* iterate over non empty lines that are not comments, after conversions
+  class LineReader
   {
+    public:
+
+    //* constructor
+    LineReader( const char* begin, const char* end, const ConversionList& conversions ):
+      fCursor( begin ),
+      fEnd( end ),
+      fConversions( conversions )
+    {}
+
+    //* next line. Returns false at end
+    bool Next( const char*& lineBegin, const char*& lineEnd )
+    {
+      while( Tokenizer::NextLine( fCursor, fEnd, lineBegin, lineEnd ) )
+      {
+        if( Tokenizer::IsComment( lineBegin, lineEnd ) ) continue;
+
+        // apply conversions, if any
+        if( !fConversions.empty() )
+        {
+          fConverted.assign( lineBegin, lineEnd );
+          for( ConversionList::const_iterator iter = fConversions.begin(); iter != fConversions.end(); iter++ )
+          { fConverted = Stream::ReplaceAll( fConverted, iter->first.Data(), iter->second.Data() ); }
+          lineBegin = fConverted.data();
+          lineEnd = lineBegin + fConverted.size();
+        }
+
+        return true;
+      }
+
+      return false;
+    }
 
-    if( !strlen( line_buffer ) ) continue;
-    if( strncmp( line_buffer, "//", 2 ) == 0 ) continue;
+    private:
 
-    // add conversions
-    std::string lineStream( line_buffer );
-    for( std::list< ConversionPair >::const_iterator iter = fConversions.begin(); iter != fConversions.end(); iter++ )
-    { lineStream = Stream::ReplaceAll( lineStream, iter->first.Data(), iter->second.Data() ); }
+    //* cursor
+    const char* fCursor;
 
-    Line line;
-    line.Parse( lineStream.c_str() );
-    if( !line.empty() ) lines.push_back( line );
+    //* end of buffer
+    const char* fEnd;
 
-  }
+    //* conversions
+    const ConversionList& fConversions;
 
-  std::cout << "Table::load - " << lines.size() << " lines read" << std::endl;
-  if( lines.empty() ) return;
+    //* converted line
+    std::string fConverted;
 
-  // retrieve number of columns
-  int nfColumns = min_element(  lines.begin(), lines.end(), SizeLessFTor() )->size();
-  std::cout << "Table::load - number of columns: " << nfColumns << std::endl;
+  };
 
-  // fill columns
-  for( int i_column=0; i_column< nfColumns; i_column++ )
+  //* values parsed from one chunk of the file
+  class Chunk
   {
+    public:
 
-    // check type
-    ColumnBase* column = 0;
-    if( lines[0].Is<double>(i_column) ) column = new ColumnDouble();
-    else column = new ColumnString();
-    for( int i_line=0; i_line < lines.size(); i_line++ )
-      column->AddValue( lines[i_line][i_column] );
+    //* constructor
+    Chunk( void ):
+      fNLines( 0 ),
+      fNColumns( 0 )
+    {}
 
-    fColumns.push_back( column );
+    //* parse lines in [begin, end), for columns of given types
+    void Parse( const char* begin, const char* end, const ConversionList& conversions, const std::vector<bool>& isDouble )
+    {
+      fNColumns = isDouble.size();
+      fDoubles.resize( fNColumns );
+      fStrings.resize( fNColumns );
+      fNInvalid.assign( fNColumns, 0 );
+
+      // reserve for the number of lines in the chunk, an upper bound on the number of values
+      const size_t nLinesMax = std::count( begin, end, '\n' ) + 1;
+      for( int column = 0; column < fNColumns; ++column )
+      {
+        if( isDouble[column] ) fDoubles[column].reserve( nLinesMax );
+        else fStrings[column].reserve( nLinesMax );
+      }
 
-  }
+      LineReader reader( begin, end, conversions );
+      const char* lineBegin;
+      const char* lineEnd;
+      const char* tokenBegin;
+      const char* tokenEnd;
+      while( reader.Next( lineBegin, lineEnd ) )
+      {
+        int column = 0;
+        const char* cursor = lineBegin;
+        while( column < int( isDouble.size() ) && Tokenizer::NextToken( cursor, lineEnd, tokenBegin, tokenEnd ) )
+        {
+          if( isDouble[column] )
+          {
+            double value = 0;
+            if( !Tokenizer::Parse( tokenBegin, tokenEnd, value ) ) ++fNInvalid[column];
+            fDoubles[column].push_back( value );
+          } else fStrings[column].push_back( TString( tokenBegin, tokenEnd - tokenBegin ) );
+          ++column;
+        }
+
+        // skip lines with no tokens
+        if( !column ) continue;
+
+        fNColumns = std::min( fNColumns, column );
+        ++fNLines;
+      }
+    }
 
-  return;
+    //* number of lines
+    int fNLines;
 
-}
+    //* smallest number of tokens in a line
+    int fNColumns;
 
-//_________________________________________________________________
-void Table::ClearConversions( void )
-{ fConversions.clear(); }
+    //* double values, per column
+    std::vector< std::vector<double> > fDoubles;
 
-//_________________________________________________________________
-int Table::GetNLines( void ) const
-{ return (*std::min_element( fColumns.begin(), fColumns.end(), SizeLessFTor() ))->Size(); }
+    //* string values, per column
+    std::vector< std::vector<TString> > fStrings;
 
-//_________________________________________________________________
-double* Table::GetDoubleArray( int column, int firstLine, int nLines ) const
-{
+    //* number of values that could not be parsed, stored as zero, per double column
+    std::vector<int> fNInvalid;
 
-  // check column index
-  if( !CheckColumn( column ) ) return 0;
+  };
 
-  // try cast column
-  ColumnDouble *column_double = static_cast<ColumnDouble*>(fColumns[column]);
-  if( !column_double )
+  //* chunk boundaries, at line starts
+  std::vector<const char*> GetChunkBoundaries( const char* begin, const char* end, int nChunks )
   {
-    std::cout << "Table::get_column_array - cannot cast column " << column << std::endl;
-    return 0;
+    std::vector<const char*> out( 1, begin );
+    for( int i = 1; i < nChunks; ++i )
+    {
+      const char* target = std::max( out.back(), begin + ( end - begin )*i/nChunks );
+      const char* newLine = static_cast<const char*>( memchr( target, '\n', end - target ) );
+      out.push_back( newLine ? newLine+1:end );
+    }
+    out.push_back( end );
+    return out;
   }
 
-  return column_double->GetArray( firstLine, nLines );
 }
 
 //_________________________________________________________________
-void Table::PrintLatex( std::ostream& out, int firstLine, int nLines ) const
+void Table::Load( const char* filename )
 {
+  if( !filename ) {
+    std::cout << "Table::load - empty string." << std::endl;
+    return;
+  }
 
-  // dump begin of table
-  if( !(fFlags & SkipHeader ) )
-  {
-    out << "\\begin{tabular}{";
+  const MappedFile file( filename );
+  if( !file.IsValid() ) {
+    std::cout << "Table::load - invalid file: " << filename << std::endl;
+    return;
+  }
 
-    Bool_t first = kTRUE;
-    for( int column = 0; column < fColumns.size(); column++ )
+  // clear columns
+  Clear();
+
+  /*
+  detect column types from the first lines. A column is a double column
+  if all its sampled values are numbers
+  */
+  std::vector<bool> isDouble;
+  {
+    LineReader reader( file.GetData(), file.GetEnd(), fConversions );
+    const char* lineBegin;
+    const char* lineEnd;
+    const char* tokenBegin;
+    const char* tokenEnd;
+    int nLines = 0;
+    while( nLines < nSampleLines && reader.Next( lineBegin, lineEnd ) )
     {
-      if( fColumns[column]->GetType() & ColumnBase::HasHeader )
+      std::vector<bool> lineIsDouble;
+      const char* cursor = lineBegin;
+      while( Tokenizer::NextToken( cursor, lineEnd, tokenBegin, tokenEnd ) )
       {
-        if(!first ) out << "|";
-        first = kFALSE;
-        out << fColumns[column]->GetAlignment();
+        double value;
+        lineIsDouble.push_back( Tokenizer::Parse( tokenBegin, tokenEnd, value ) );
       }
-    }
 
-    out << "}" << std::endl;
+      // skip lines with no tokens
+      if( lineIsDouble.empty() ) continue;
 
-    for( int column = 0; column < fColumns.size(); column++ )
-    {
-      if( column != 0 && (fColumns[column]->GetType() & ColumnBase::HasHeader) ) out << " & " << fColumns[column]->GetName();
-      else if( column == 0 && (fColumns[column]->GetType() & ColumnBase::HasHeader) ) out << fColumns[column]->GetName();
+      if( !nLines++ ) isDouble.swap( lineIsDouble );
+      else {
+        isDouble.resize( std::min( isDouble.size(), lineIsDouble.size() ) );
+        for( size_t i = 0; i < isDouble.size(); ++i ) isDouble[i] = isDouble[i] && lineIsDouble[i];
+      }
     }
+  }
 
-    out << "\\\\" << std::endl;
+  // parse chunks in parallel
+  const int nChunks = WorkerPool::GetNWorkers( fNWorkers, file.GetSize()/minChunkSize + 1 );
+  const std::vector<const char*> boundaries( GetChunkBoundaries( file.GetData(), file.GetEnd(), nChunks ) );
+  std::vector<Chunk> chunks( nChunks );
+  WorkerPool::Run( nChunks, nChunks, [&]( unsigned int, unsigned int first, unsigned int end )
+    {
+      for( unsigned int chunk = first; chunk < end; ++chunk )
+      { chunks[chunk].Parse( boundaries[chunk], boundaries[chunk+1], fConversions, isDouble ); }
+    } );
+
+  // total number of lines and columns
+  int nLines = 0;
+  int nColumns = isDouble.size();
+  for( const auto& chunk:chunks )
+  {
+    nLines += chunk.fNLines;
+    if( chunk.fNLines ) nColumns = std::min( nColumns, chunk.fNColumns );
   }
 
-  out << "\\hline" << std::endl;
+  std::cout << "Table::load - " << nLines << " lines read" << std::endl;
+  if( !nLines ) return;
 
-  // get min number of entries in the columns
-  int nLinesMax = (*std::min_element( fColumns.begin(), fColumns.end(), SizeLessFTor() ))->Size();
-  if( nLines ) nLinesMax = std::min( nLinesMax, nLines+firstLine );
+  std::cout << "Table::load - number of columns: " << nColumns << std::endl;
 
-  // dump values
-  for( int line = firstLine; line < nLinesMax; line++ )
+  // values of double columns that are not numbers past the sampled lines
+  for( int i = 0; i < nColumns; ++i )
   {
-    for( int column = 0; column < fColumns.size(); column++ )
-    {
-      std::string valueString( fColumns[column]->GetString(line) );
-
-      // convert exp to latex format
-      while( valueString.find( "e-0" ) != std::string::npos ) valueString = Stream::ReplaceAll( valueString, "e-0", "e-" );
-      while( valueString.find( "e0" ) != std::string::npos ) valueString = Stream::ReplaceAll( valueString, "e0", "e" );
-      if( valueString.find( "e" ) != std::string::npos ) valueString = Stream::ReplaceAll( valueString, "e", "\\;10^{" )+"}";
-
-      // print column
-      if( column == 0 ) out << "$";
-      else if( fColumns[column]->GetType() & ColumnBase::HasHeader ) out << "$ & $";
-      if( fColumns[column]->GetType() == ColumnBase::IntervalBegin ) out << "[";
-      if( fColumns[column]->GetType() == ColumnBase::IntervalEnd ) out << " , ";
-      if( fColumns[column]->GetType() == ColumnBase::Error ) out << " \\pm ";
-      if( fColumns[column]->GetType() == ColumnBase::ErrorPlus ) out << "^{+";
-      if( fColumns[column]->GetType() == ColumnBase::ErrorMinus ) out << "_{-";
-      if( fColumns[column]->GetType() == ColumnBase::ErrorRel ) out << "\\;(";
-      out << valueString;
-      if( fColumns[column]->GetType() == ColumnBase::ErrorPlus ) out << "}";
-      if( fColumns[column]->GetType() == ColumnBase::ErrorMinus ) out << "}";
-      if( fColumns[column]->GetType() == ColumnBase::IntervalEnd ) out << "]";
-      if( fColumns[column]->GetType() == ColumnBase::ErrorRel ) out << "\\%)";
+    if( !isDouble[i] ) continue;
+    int nInvalid = 0;
+    for( const auto& chunk:chunks ) nInvalid += chunk.fNInvalid[i];
+    if( nInvalid ) std::cout << "Table::Load - column " << i << ": " << nInvalid << " invalid values" << std::endl;
+  }
 
+  /*
+  concatenate chunks, in order. Chunk values are moved, and released column by column,
+  so that peak memory exceeds the parsed values by at most one column
+  */
+  for( int i = 0; i < nColumns; ++i )
+  {
+    if( isDouble[i] )
+    {
+      ColumnDouble* column = new ColumnDouble();
+      if( nChunks > 1 ) column->Reserve( nLines );
+      for( auto& chunk:chunks ) column->Append( std::move( chunk.fDoubles[i] ) );
+      fColumns.push_back( column );
+    } else {
+      ColumnString* column = new ColumnString();
+      if( nChunks > 1 ) column->Reserve( nLines );
+      for( auto& chunk:chunks ) column->Append( std::move( chunk.fStrings[i] ) );
+      fColumns.push_back( column );
     }
-    out << "$ \\\\" << std::endl;
+  }
 
-    if( fHorizontalLines.find( line+1 ) != fHorizontalLines.end() )
-    { out << "\\hline" << std::endl; }
+  return;
+
+}
 
+//_________________________________________________________________
+void Table::LoadBinary( const char* filename )
+{
+  if( !filename ) {
+    std::cout << "Table::LoadBinary - empty string." << std::endl;
+    return;
   }
 
-  if( !(fFlags & SkipTrailer ) )
-  {
-    out << "\\end{tabular}" << std::endl;
-    out << std::endl;
+  const BinaryTable file( filename );
+  if( !file.IsValid() ) return;
+
+  // clear columns
+  Clear();
+  file.Fill( *this );
+
+  std::cout << "Table::LoadBinary - " << file.GetNRows() << " lines read" << std::endl;
+  std::cout << "Table::LoadBinary - number of columns: " << fColumns.size() << std::endl;
+
+}
+
+//_________________________________________________________________
+bool Table::SaveBinary( const char* filename, int compression ) const
+{
+  if( !filename ) {
+    std::cout << "Table::SaveBinary - empty string." << std::endl;
+    return false;
   }
 
+  return BinaryTable::Write( *this, filename, compression );
 }
 
 //_________________________________________________________________
-void Table::PrintText( std::ostream& out, int firstLine, int nLines ) const
+void Table::LoadCsv( const char* filename, char separator, bool header )
 {
+  if( !filename ) {
+    std::cout << "Table::LoadCsv - empty string." << std::endl;
+    return;
+  }
+
+  // clear columns
+  Clear();
+  CsvTable::Read( *this, filename, CsvTable::Options( separator, header ) );
+}
+
+//_________________________________________________________________
+bool Table::SaveCsv( const char* filename, char separator, bool header ) const
+{
+  if( !filename ) {
+    std::cout << "Table::SaveCsv - empty string." << std::endl;
+    return false;
+  }
+
+  return CsvTable::Write( *this, filename, CsvTable::Options( separator, header ) );
+}
+
+//_________________________________________________________________
+void Table::ClearConversions( void )
+{ fConversions.clear(); }
+
+//_________________________________________________________________
+int Table::GetNLines( void ) const
+{ return (*std::min_element( fColumns.begin(), fColumns.end(), SizeLessFTor() ))->Size(); }
 
+namespace
+{
 
-  // dump header
-  if( !(fFlags & SkipHeader) )
+  //* convert values to a new double array
+  template<typename T> double* ToDoubleArray( const ColumnSpan<T>& values, int firstLine, int nLines )
   {
-    for( int column = 0; column < fColumns.size(); column++ )
-      if( column != 0 ) out << "   " << fColumns[column]->GetName();
-    else out << fColumns[column]->GetName();
+    const int nLinesMax = ( nLines )? std::min<int>( values.size(), nLines+firstLine ):values.size();
+    double* out = new double[nLinesMax-firstLine];
+    for( int i = firstLine; i < nLinesMax; i++ )
+    { out[i-firstLine] = values[i]; }
 
-    out << std::endl;
+    return out;
   }
 
-  // get min number of entries in the columns
-  int nLinesMax = (*std::min_element( fColumns.begin(), fColumns.end(), SizeLessFTor() ))->Size();
-  if( nLines ) nLinesMax = std::min( nLinesMax, nLines+firstLine );
+}
 
-  // dump values
-  for( int line = firstLine; line < nLinesMax; line++ )
-  {
-    for( int column = 0; column < fColumns.size(); column++ )
-    {
-      std::string valueString( fColumns[column]->GetString(line) );
-
-      // convert exp to latex format
-      while( valueString.find( "e-0" ) != std::string::npos ) valueString = Stream::ReplaceAll( valueString, "e-0", "e-" );
-      while( valueString.find( "e0" ) != std::string::npos ) valueString = Stream::ReplaceAll( valueString, "e0", "e" );
-      if( valueString.find( "e" ) != std::string::npos )
-        valueString = Stream::ReplaceAll( valueString, "e", " 10^" );
-
-      // print column
-      else if( fColumns[column]->GetType() & ColumnBase::HasHeader ) out << "   ";
-      if( fColumns[column]->GetType() == ColumnBase::IntervalBegin ) out << "[";
-      if( fColumns[column]->GetType() == ColumnBase::IntervalEnd ) out << " , ";
-      if( fColumns[column]->GetType() == ColumnBase::Error ) out << " +/- ";
-      if( fColumns[column]->GetType() == ColumnBase::ErrorPlus ) out << " +";
-      if( fColumns[column]->GetType() == ColumnBase::ErrorMinus ) out << " -";
-      out << valueString;
-      if( fColumns[column]->GetType() == ColumnBase::IntervalEnd ) out << "]";
+//_________________________________________________________________
+double* Table::GetDoubleArray( int column, int firstLine, int nLines ) const
+{
 
-    }
-    if( !( fFlags & SkipTrailer ) ) { out << std::endl; }
+  // check column index
+  if( !CheckColumn( column ) ) return 0;
+
+  // try cast column
+  const ColumnBase* base = fColumns[column];
+  if( const ColumnDouble* typed = dynamic_cast<const ColumnDouble*>( base ) ) return typed->GetArray( firstLine, nLines );
+  else if( const ColumnInt* typed = dynamic_cast<const ColumnInt*>( base ) ) return ToDoubleArray( typed->GetSpan(), firstLine, nLines );
+  else if( const ColumnFloat* typed = dynamic_cast<const ColumnFloat*>( base ) ) return ToDoubleArray( typed->GetSpan(), firstLine, nLines );
+  else if( const ColumnBool* typed = dynamic_cast<const ColumnBool*>( base ) ) return ToDoubleArray( typed->GetSpan(), firstLine, nLines );
+  else {
+    std::cout << "Table::get_column_array - cannot cast column " << column << std::endl;
+    return 0;
   }
+}
 
+//_________________________________________________________________
+void Table::PrintLatex( std::ostream& out, int firstLine, int nLines ) const
+{
+  TableWriter writer( *this, out, TableWriter::Latex );
+  writer.WriteHeader();
+  writer.WriteRows( firstLine, nLines ? nLines+firstLine:writer.GetNLines() );
+  writer.WriteTrailer();
+}
+
+//_________________________________________________________________
+void Table::PrintText( std::ostream& out, int firstLine, int nLines ) const
+{
+  TableWriter writer( *this, out, TableWriter::Text );
+  writer.WriteHeader();
+  writer.WriteRows( firstLine, nLines ? nLines+firstLine:writer.GetNLines() );
+  writer.WriteTrailer();
 }
 
 //_________________________________________________________________
 void Table::PrintC( std::ostream& out, int firstLine, int nLines ) const
 {
 
+  if( fColumns.empty() ) return;
+
+  // get min number of entries in the columns
+  int nLinesMax = GetNLines();
+  if( nLines ) nLinesMax = std::min( nLinesMax, nLines+firstLine );
+
   // dump values
   for( int column = 0; column < fColumns.size(); column++ )
   {
 
-    // get min number of entries in the columns
-    int nLinesMax = (*std::min_element( fColumns.begin(), fColumns.end(), SizeLessFTor() ))->Size();
-    if( nLines ) nLinesMax = std::min( nLinesMax, nLines+firstLine );
-
     if( nLinesMax == 1 )
     {
       out << "const Double_t " << fColumns[column]->GetName() << " = " <<  fColumns[column]->GetString(firstLine) << ";" << std::endl;
@@ -290,65 +501,8 @@ void Table::PrintC( std::ostream& out, int firstLine, int nLines ) const
 //_________________________________________________________________
 void Table::PrintHep( std::ostream& out, int firstLine, int nLines ) const
 {
-
-  if( !(fFlags & SkipHeader) )
-  { out << "*dataset:" << std::endl; }
-
-  // get min number of entries in the columns
-  int nLinesMax = (*std::min_element( fColumns.begin(), fColumns.end(), SizeLessFTor() ))->Size();
-  if( nLines ) nLinesMax = std::min( nLinesMax, nLines+firstLine );
-
-  // dump values
-  for( int line = firstLine; line < nLinesMax; line++ )
-  {
-
-    bool foundSyst( false );
-    bool hasSyst( false );
-    bool hasStat( false );
-    for( int column = 0; column < fColumns.size(); column++ )
-    {
-      std::string valueString( fColumns[column]->GetString(line) );
-
-      // formats
-      if( fColumns[column]->GetType() & ColumnBase::ErrorSyst && !hasSyst )
-      {
-        foundSyst = true;
-        out << " (DSYS=";
-      }
-
-      if( fColumns[column]->GetType() & ColumnBase::ErrorPlus )
-      {
-        if( fColumns[column]->GetType() & ColumnBase::ErrorSyst && hasSyst ) out << "; DSYS=";
-        out << " +";
-      }
-      else if( fColumns[column]->GetType() & ColumnBase::ErrorMinus ) out << " , -";
-      else if( fColumns[column]->GetType() & ColumnBase::Error )
-      {
-        if( fColumns[column]->GetType() & ColumnBase::ErrorStat ) out << " +- ";
-        else if( fColumns[column]->GetType() & ColumnBase::ErrorSyst && hasSyst ) out << "; DSYS=";
-      }
-      else if( fColumns[column]->GetType() & ColumnBase::IntervalEnd ) out << " TO ";
-      else if( column > 0 ) out << "; ";
-
-      // value
-      out << valueString;
-
-      // trailer
-      if( (fColumns[column]->GetType() & (ColumnBase::Error|ColumnBase::ErrorMinus) ) &&
-        ( fColumns[column]->GetType() & ColumnBase::ErrorSyst ) &&
-        !fColumns[column]->GetName().IsNull() )
-      { out << ":" << fColumns[column]->GetName(); }
-
-      if( foundSyst ) hasSyst = true;
-
-    }
-
-    if( hasSyst ) out << ");" << std::endl;
-    else out << ";" << std::endl;
-
-  }
-
-  if( !(fFlags & SkipTrailer) )
-  { out << "*dataend:" << std::endl << std::endl; }
-
+  TableWriter writer( *this, out, TableWriter::Hep );
+  writer.WriteHeader();
+  writer.WriteRows( firstLine, nLines ? nLines+firstLine:writer.GetNLines() );
+  writer.WriteTrailer();
 }
@@ -12,6 +12,8 @@
 #include <cmath>
 
 #ifndef __CINT__
+#include <functional>
+#include <iterator>
 #include <map>
 #include <list>
 #include <set>
@@ -45,7 +47,8 @@ class ColumnBase
         fName( name ),
         fFormat( format ),
         fType( type ),
-        fAlignment( "c" )
+        fAlignment( "c" ),
+        fVersion( 0 )
     {}
 
     //* destructor
@@ -68,6 +71,14 @@ class ColumnBase
     virtual const TString& GetAlignment( void ) const
     { return fAlignment; }
 
+    //* version, incremented each time values change
+    unsigned long GetVersion( void ) const
+    { return fVersion; }
+
+    //* bring values up to date. Only derived columns are computed on access
+    virtual void Update( void ) const
+    {}
+
     //* name
     virtual void SetName( const TString& name )
     { fName = name; }
@@ -136,6 +147,14 @@ class ColumnBase
         return false;
     }
 
+    //* new column with same name, format, type and alignment, holding the values at given rows
+    virtual ColumnBase* Take( const std::vector<int>& rows ) const
+    {
+
+        std::cout << "ColumnBase::Take - not implemented" << std::endl;
+        return 0;
+    }
+
     protected:
 
     //* column name
@@ -150,6 +169,13 @@ class ColumnBase
     //* alignment
     TString fAlignment;
 
+    //* mark values as changed
+    void Touch( void )
+    { ++fVersion; }
+
+    //* version
+    unsigned long fVersion;
+
     //* root dictionary
     ClassDef( ColumnBase, 0 );
 
@@ -157,6 +183,52 @@ class ColumnBase
 
 #ifndef __CINT__
 
+//* non owning, read only view on contiguous column values
+template<typename T> class ColumnSpan
+{
+
+    public:
+
+    //* constructor
+    ColumnSpan( const T* data = 0, size_t size = 0 ):
+        fData( data ),
+        fSize( size )
+    {}
+
+    //* data
+    const T* data( void ) const
+    { return fData; }
+
+    //* size
+    size_t size( void ) const
+    { return fSize; }
+
+    //* true if empty
+    bool empty( void ) const
+    { return !fSize; }
+
+    //* value
+    const T& operator[]( size_t index ) const
+    { return fData[index]; }
+
+    //* begin
+    const T* begin( void ) const
+    { return fData; }
+
+    //* end
+    const T* end( void ) const
+    { return fData + fSize; }
+
+    private:
+
+    //* data
+    const T* fData;
+
+    //* size
+    size_t fSize;
+
+};
+
 //* templatized column class
 template<typename T> class Column: public ColumnBase
 {
@@ -179,11 +251,42 @@ template<typename T> class Column: public ColumnBase
 
     //* values
     virtual const std::vector<T>& GetValues( void ) const
-    { return fValues; }
+    {
+        Update();
+        return fValues;
+    }
+
+    //* values, as a span
+    ColumnSpan<T> GetSpan( void ) const
+    {
+        Update();
+        return ColumnSpan<T>( fValues.data(), fValues.size() );
+    }
+
+    //* append value
+    void Append( const T& value )
+    {
+        fValues.push_back( value );
+        Touch();
+    }
+
+    //* append values, moved from input, which is released
+    void Append( std::vector<T>&& values )
+    {
+        Touch();
+        if( fValues.empty() && fValues.capacity() <= values.capacity() ) fValues.swap( values );
+        else fValues.insert( fValues.end(), std::make_move_iterator( values.begin() ), std::make_move_iterator( values.end() ) );
+        std::vector<T>().swap( values );
+    }
+
+    //* reserve space for values
+    void Reserve( int size )
+    { fValues.reserve( size ); }
 
     //* values
     virtual bool AddValue( const TString& value )
     {
+        Touch();
         T out;
         std::istringstream in( value.Data() );
         in >> out;
@@ -206,6 +309,8 @@ template<typename T> class Column: public ColumnBase
     virtual T* GetArray( int firstLine = 0, int nLines = 0 ) const
     {
 
+        Update();
+
       // get min number of entries in the columns
         int nLinesMax = ( nLines )? std::min<int>( fValues.size(), nLines+firstLine ):fValues.size();
         T* out = new T[nLinesMax-firstLine];
@@ -224,6 +329,7 @@ template<typename T> class Column: public ColumnBase
     //* shrink column size
     virtual void Shrink( int newSize )
     {
+        Touch();
         while( fValues.size() > newSize )
             fValues.pop_back();
         return;
@@ -232,6 +338,7 @@ template<typename T> class Column: public ColumnBase
     //* expand column size
     virtual void Expand( int newSize )
     {
+        Touch();
         T value;
         if( !fValues.empty() ) value = fValues.back();
         for( int i= fValues.size(); i<newSize; i++ )
@@ -241,6 +348,20 @@ template<typename T> class Column: public ColumnBase
 
     protected:
 
+    //* copy description from source, and values at given rows
+    void TakeFrom( const Column<T>& source, const std::vector<int>& rows )
+    {
+        source.Update();
+        Touch();
+        SetName( source.GetName() );
+        SetFormat( source.GetFormat() );
+        SetType( source.GetType() );
+        SetAlignment( source.GetAlignment() );
+        fValues.resize( rows.size() );
+        for( size_t i = 0; i < rows.size(); i++ )
+        { fValues[i] = source.fValues[rows[i]]; }
+    }
+
     //* vector values
     std::vector<T> fValues;
 
@@ -280,9 +401,18 @@ class ColumnDouble: public Column<double>
     virtual ~ColumnDouble( void )
     {}
 
+    //* new column holding the values at given rows
+    virtual ColumnBase* Take( const std::vector<int>& rows ) const
+    {
+        ColumnDouble* out = new ColumnDouble();
+        out->TakeFrom( *this, rows );
+        return out;
+    }
+
     //* scale all values
     virtual void Scale( double value )
     {
+        Touch();
         for( int i=0; i<fValues.size(); i++ )
         { fValues[i]*=value; }
     }
@@ -290,6 +420,7 @@ class ColumnDouble: public Column<double>
     //* scale all values
     virtual void Scale( double* value )
     {
+        Touch();
         for( int i=0; i<fValues.size(); i++ )
         { fValues[i]*=value[i]; }
     }
@@ -301,6 +432,133 @@ class ColumnDouble: public Column<double>
 
 };
 
+//* column of integers
+class ColumnInt: public Column<int>
+{
+
+    public:
+
+    //* constructor
+    ColumnInt(
+        const char* name = "",
+        const int* values = 0,
+        int size = 0,
+        const char* format = "%d",
+        int type = None ):
+        Column<int>( name, 0, 0, format, type )
+    { fValues.assign( values, values+size ); }
+
+    //* destructor
+    virtual ~ColumnInt( void )
+    {}
+
+    //* new column holding the values at given rows
+    virtual ColumnBase* Take( const std::vector<int>& rows ) const
+    {
+        ColumnInt* out = new ColumnInt();
+        out->TakeFrom( *this, rows );
+        return out;
+    }
+
+    //* print column, formated
+    virtual TString GetString( int index ) const
+    { return Form( GetFormat().Data(), fValues[index] ); }
+
+};
+
+//* column of floats
+class ColumnFloat: public Column<float>
+{
+
+    public:
+
+    //* constructor
+    ColumnFloat(
+        const char* name = "",
+        const float* values = 0,
+        int size = 0,
+        const char* format = "%f",
+        int type = None ):
+        Column<float>( name, 0, 0, format, type )
+    { fValues.assign( values, values+size ); }
+
+    //* destructor
+    virtual ~ColumnFloat( void )
+    {}
+
+    //* new column holding the values at given rows
+    virtual ColumnBase* Take( const std::vector<int>& rows ) const
+    {
+        ColumnFloat* out = new ColumnFloat();
+        out->TakeFrom( *this, rows );
+        return out;
+    }
+
+    //* scale all values
+    virtual void Scale( double value )
+    {
+        Touch();
+        for( size_t i=0; i<fValues.size(); i++ )
+        { fValues[i]*=value; }
+    }
+
+    //* scale all values
+    virtual void Scale( double* value )
+    {
+        Touch();
+        for( size_t i=0; i<fValues.size(); i++ )
+        { fValues[i]*=value[i]; }
+    }
+
+    //* print column, formated
+    virtual TString GetString( int index ) const
+    { return Form( GetFormat().Data(), fValues[index] ); }
+
+};
+
+//* column of booleans, stored as one byte per value (0 or 1) so that values are contiguous
+class ColumnBool: public Column<unsigned char>
+{
+
+    public:
+
+    //* constructor
+    ColumnBool(
+        const char* name = "",
+        const bool* values = 0,
+        int size = 0,
+        const char* format = "%d",
+        int type = None ):
+        Column<unsigned char>( name, 0, 0, format, type )
+    { for( int i=0; i<size; i++ ) fValues.push_back( values[i] ); }
+
+    //* destructor
+    virtual ~ColumnBool( void )
+    {}
+
+    //* new column holding the values at given rows
+    virtual ColumnBase* Take( const std::vector<int>& rows ) const
+    {
+        ColumnBool* out = new ColumnBool();
+        out->TakeFrom( *this, rows );
+        return out;
+    }
+
+    //* add value. Accepts 0, 1, false and true
+    virtual bool AddValue( const TString& value )
+    {
+        const bool isTrue( value == "1" || value == "true" );
+        fValues.push_back( isTrue );
+        Touch();
+        return isTrue || value == "0" || value == "false";
+    }
+
+    //* print column, formated
+    virtual TString GetString( int index ) const
+    { return Form( GetFormat().Data(), int( fValues[index] ) ); }
+
+};
+
 //* column of strings
 class ColumnString: public Column<TString>
 {
@@ -334,12 +592,123 @@ class ColumnString: public Column<TString>
     virtual ~ColumnString( void )
     {}
 
+    //* new column holding the values at given rows
+    virtual ColumnBase* Take( const std::vector<int>& rows ) const
+    {
+        ColumnString* out = new ColumnString();
+        out->TakeFrom( *this, rows );
+        return out;
+    }
+
     //* GetString column, formated
     virtual TString GetString( int index ) const
     { return fValues[index]; }
 
 };
 
+/*!
+column of doubles computed from other numeric columns.
+Values are computed on first access, by a single call to the function over all lines,
+and memoized. They are recomputed only when the version of a source column has changed.
+Derived columns can be used as sources of other derived columns. They cannot be modified
+*/
+class ColumnDerived: public ColumnDouble
+{
+
+    public:
+
+    //* function filling output from source values. All spans have the output size
+    typedef std::function<void( const std::vector< ColumnSpan<double> >& sources, double* output, int size )> Function;
+
+    //* constructor. Source columns are not owned
+    ColumnDerived(
+        const char* name,
+        const std::vector<const ColumnBase*>& sources,
+        Function function,
+        const char* format = "%f",
+        int type = None ):
+        ColumnDouble( name, static_cast<const double*>( 0 ), 0, format, type ),
+        fSources( sources ),
+        fFunction( function ),
+        fEvaluated( false )
+    {}
+
+    //* destructor
+    virtual ~ColumnDerived( void )
+    {}
+
+    //* true if column can be used as a source
+    static bool IsNumeric( const ColumnBase* column )
+    {
+        return
+            dynamic_cast<const Column<double>*>( column ) ||
+            dynamic_cast<const Column<float>*>( column ) ||
+            dynamic_cast<const Column<int>*>( column ) ||
+            dynamic_cast<const Column<unsigned char>*>( column );
+    }
+
+    //* data size: smallest source size
+    virtual int Size( void ) const
+    {
+        if( fSources.empty() ) return 0;
+        int out = fSources[0]->Size();
+        for( size_t i = 1; i < fSources.size(); i++ )
+        { out = std::min( out, fSources[i]->Size() ); }
+        return out;
+    }
+
+    //* recompute values if a source has changed
+    virtual void Update( void ) const;
+
+    //* print column, formated
+    virtual TString GetString( int index ) const
+    {
+        Update();
+        return ColumnDouble::GetString( index );
+    }
+
+    //* derived columns are read only
+    virtual void Scale( double value )
+    { std::cout << "ColumnDerived::Scale - derived columns are read only" << std::endl; }
+
+    //* derived columns are read only
+    virtual void Scale( double* value )
+    { std::cout << "ColumnDerived::Scale - derived columns are read only" << std::endl; }
+
+    //* derived columns are read only
+    virtual void Shrink( int newSize )
+    { std::cout << "ColumnDerived::Shrink - derived columns are read only" << std::endl; }
+
+    //* derived columns are read only
+    virtual void Expand( int newSize )
+    { std::cout << "ColumnDerived::Expand - derived columns are read only" << std::endl; }
+
+    //* derived columns are read only
+    virtual bool AddValue( const TString& value )
+    {
+        std::cout << "ColumnDerived::AddValue - derived columns are read only" << std::endl;
+        return false;
+    }
+
+    private:
+
+    //* source columns
+    std::vector<const ColumnBase*> fSources;
+
+    //* function
+    Function fFunction;
+
+    //* true once values have been computed
+    mutable bool fEvaluated;
+
+    //* source versions used for the last evaluation
+    mutable std::vector<unsigned long> fSourceVersions;
+
+    //* source values converted to double, for sources that are not double columns
+    mutable std::vector< std::vector<double> > fBuffers;
+
+};
+
 #endif
 
 //* line objects, used to Parse tables from file
@@ -398,7 +767,8 @@ class Table: public TObject
 
     //* constructor
     Table( void ):
-        fFlags( None )
+        fFlags( None ),
+        fNWorkers( 0 )
     {}
 
     //* destructor
@@ -424,6 +794,10 @@ class Table: public TObject
     void SetFlags( int flags )
     { fFlags = flags; }
 
+    //* number of workers used to load files. Zero means one per hardware thread
+    void SetNWorkers( unsigned int value )
+    { fNWorkers = value; }
+
     //* add conversion pairs
     void AddConversion( const char* c1, const char* c2 );
 
@@ -438,9 +812,46 @@ class Table: public TObject
         fColumns.clear();
     }
 
-    //* load table from a txt file
+    /*!
+    load table from a txt file.
+    The file is memory mapped and tokenized in place. Empty lines and lines starting with
+    "//" are skipped. The number of columns is the smallest number of tokens in a line.
+    Columns whose values are all numbers in the first lines of the file are parsed as
+    doubles, others as strings. Later values of double columns that are not numbers are
+    stored as zero and counted. Large files are split at line boundaries into chunks,
+    parsed in parallel and concatenated in order
+    */
     void Load( const char* filename );
 
+    /*!
+    load table from a binary file written by SaveBinary.
+    Values are copied from the memory mapped file, see BinaryTable
+    */
+    void LoadBinary( const char* filename );
+
+    /*!
+    save table to a binary columnar file, see BinaryTable.
+    Compression follows ROOT compression settings, zero for none
+    */
+    bool SaveBinary( const char* filename, int compression = 0 ) const;
+
+    /*!
+    load table from a csv file, see CsvTable. Use a tab separator for tsv files.
+    Column names are read from the first line if header is true.
+    Column types are inferred from the first lines of the file
+    */
+    void LoadCsv( const char* filename, char separator = ',', bool header = true );
+
+    /*!
+    save table to a csv file, see CsvTable. Use a tab separator for tsv files.
+    Numbers are written with full precision, independently of the column format
+    */
+    bool SaveCsv( const char* filename, char separator = ',', bool header = true ) const;
+
+    //* Add a column. Table takes ownership
+    void AddColumn( ColumnBase* column )
+    { if( column ) fColumns.push_back( column ); }
+
     //* Add a column
     void AddColumn(
         const char* name,
@@ -468,6 +879,35 @@ class Table: public TObject
         const char* format = "%f" )
     { fColumns.push_back( new ColumnDouble( name, values, size, format, ColumnBase::Error ) ); }
 
+    #ifndef __CINT__
+    /*!
+    Add a column computed from numeric source columns, see ColumnDerived.
+    The function is called on first access to the values, and again only when a source has changed
+    */
+    void AddDerivedColumn(
+        const char* name,
+        const std::vector<int>& sources,
+        ColumnDerived::Function function,
+        const char* format = "%f",
+        int type = ColumnBase::None )
+    {
+        std::vector<const ColumnBase*> columns;
+        for( size_t i = 0; i < sources.size(); i++ )
+        {
+            if( !CheckColumn( sources[i] ) ) return;
+            if( !ColumnDerived::IsNumeric( fColumns[sources[i]] ) )
+            {
+                std::cout << "Table::AddDerivedColumn - column " << sources[i] << " is not numeric" << std::endl;
+                return;
+            }
+
+            columns.push_back( fColumns[sources[i]] );
+        }
+
+        fColumns.push_back( new ColumnDerived( name, columns, function, format, type ) );
+    }
+    #endif
+
     //@}
 
 
@@ -529,8 +969,16 @@ class Table: public TObject
     {
         if( !CheckColumn( first ) ) return;
         if( !CheckColumn( second ) ) return;
+        if( fColumns[second]->Size() < fColumns[first]->Size() )
+        {
+            std::cout << "Table::MultiplyColumn - column " << second << " is shorter than column " << first << std::endl;
+            return;
+        }
+
         double *value = GetDoubleArray( second );
+        if( !value ) return;
         fColumns[first]->Scale( value );
+        delete[] value;
     }
 
     //* expand column with its last value so that its size is the newSize
@@ -551,14 +999,41 @@ class Table: public TObject
     //* get number of lines
     int GetNLines( void ) const;
 
+    //* get column
+    ColumnBase* GetColumn( int column ) const
+    { return CheckColumn( column ) ? fColumns[column]:0; }
+
     //@}
 
     //*@name dumpers
     //@{
 
-    //* retrieve column double values
+    /*!
+    retrieve column double values, for double, int, float and bool columns.
+    Note that a new array is created at each call and needs to be deleted from the calling method
+    */
     double* GetDoubleArray( int column, int firstLine = 0, int nLines = 0 ) const;
 
+    #ifndef __CINT__
+    /*!
+    retrieve column values, without copy. Column type must match exactly,
+    for instance double for ColumnDouble and unsigned char for ColumnBool.
+    The span is invalidated by any change to the column
+    */
+    template<typename T> ColumnSpan<T> GetColumnSpan( int column ) const
+    {
+        if( !CheckColumn( column ) ) return ColumnSpan<T>();
+        const Column<T>* typed = dynamic_cast<const Column<T>*>( fColumns[column] );
+        if( !typed )
+        {
+            std::cout << "Table::GetColumnSpan - invalid type for column " << column << std::endl;
+            return ColumnSpan<T>();
+        }
+
+        return typed->GetSpan();
+    }
+    #endif
+
     //* print table in latex format
     void PrintLatex( int firstLine = 0, int nLines = 0 ) const
     { PrintLatex( std::cout, firstLine, nLines ); }
@@ -601,9 +1076,15 @@ class Table: public TObject
 
     private:
 
+    //* writer accesses flags, columns and horizontal lines
+    friend class TableWriter;
+
     //* flags
     int fFlags;
 
+    //* number of workers used to load files
+    unsigned int fNWorkers;
+
     //* list of columns
     std::vector< ColumnBase* > fColumns;
 
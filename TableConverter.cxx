@@ -0,0 +1,478 @@
+#include "TableConverter.h"
+#include "Table.h"
+#include "TableQuery.h"
+#include "Utils.h"
+
+#include <TBranch.h>
+#include <TGraphAsymmErrors.h>
+#include <TGraphErrors.h>
+#include <TH1.h>
+#include <TLeaf.h>
+#include <TObjArray.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <set>
+#include <utility>
+
+/*!
+  \file TableConverter.cxx
+  \brief bulk conversion between tables and ROOT trees, graphs and histograms
+*/
+
+namespace
+{
+
+  //__________________________________________________________________
+  //* create branch and fill it over all rows. Tree entries are set by the caller
+  template<typename T, typename S> void FillBranch( TTree* tree, const TString& name, const char* leafType, const ColumnSpan<S>& values, int nLines )
+  {
+    T value = T();
+    TBranch* branch = tree->Branch( name, &value, Form( "%s/%s", name.Data(), leafType ) );
+    for( int i = 0; i < nLines; ++i )
+    {
+      value = values[i];
+      branch->Fill();
+    }
+
+    branch->ResetAddress();
+  }
+
+  //__________________________________________________________________
+  //* create string branch and fill it over all rows
+  void FillStringBranch( TTree* tree, const TString& name, const ColumnBase* column, int nLines )
+  {
+    std::vector<TString> values( nLines );
+    size_t size = 1;
+    for( int i = 0; i < nLines; ++i )
+    {
+      values[i] = column->GetString( i );
+      size = std::max<size_t>( size, values[i].Length()+1 );
+    }
+
+    std::vector<char> buffer( size, 0 );
+    TBranch* branch = tree->Branch( name, &buffer[0], Form( "%s/C", name.Data() ) );
+    for( int i = 0; i < nLines; ++i )
+    {
+      strcpy( &buffer[0], values[i].Data() );
+      branch->Fill();
+    }
+
+    branch->ResetAddress();
+  }
+
+  //__________________________________________________________________
+  /*!
+  call function with the named branch of each tree, first local entry and number of entries,
+  so that TChain entries are read from the tree that holds them. Returns false if a tree lacks the branch
+  */
+  template<typename F> bool ForEachTree( TTree* tree, const TString& name, Long64_t nEntries, F function )
+  {
+    for( Long64_t entry = 0; entry < nEntries; )
+    {
+      const Long64_t local = tree->LoadTree( entry );
+      TTree* current = local >= 0 ? tree->GetTree():0;
+      TBranch* branch = current ? current->GetBranch( name ):0;
+      const Long64_t n = branch ? std::min( current->GetEntries() - local, nEntries - entry ):0;
+      if( n <= 0 )
+      {
+        std::cout << "TableConverter::FromTree - cannot read branch " << name << " at entry " << entry << std::endl;
+        return false;
+      }
+
+      function( branch, local, n );
+      entry += n;
+    }
+
+    return true;
+  }
+
+  //__________________________________________________________________
+  //* single leaf of a branch
+  TLeaf* GetLeaf( TBranch* branch )
+  { return static_cast<TLeaf*>( branch->GetListOfLeaves()->UncheckedAt( 0 ) ); }
+
+  //__________________________________________________________________
+  //* read all entries of a single leaf branch into a new column. Returns null on error
+  template<typename T, typename C> C* ReadBranch( TTree* tree, const TString& name, Long64_t nEntries )
+  {
+    C* column = new C();
+    column->SetName( name );
+    column->Reserve( nEntries );
+
+    const bool valid = ForEachTree( tree, name, nEntries, [column]( TBranch* branch, Long64_t first, Long64_t n )
+      {
+        T value = T();
+        branch->SetAddress( &value );
+        for( Long64_t i = first; i < first+n; ++i )
+        {
+          branch->GetEntry( i );
+          column->Append( value );
+        }
+
+        branch->ResetAddress();
+      } );
+
+    if( valid ) return column;
+    delete column;
+    return 0;
+  }
+
+  //__________________________________________________________________
+  //* read all entries of a string branch into a new column. Returns null on error
+  ColumnString* ReadStringBranch( TTree* tree, const TString& name, Long64_t nEntries )
+  {
+    ColumnString* column = new ColumnString();
+    column->SetName( name );
+    column->Reserve( nEntries );
+
+    const bool valid = ForEachTree( tree, name, nEntries, [column]( TBranch* branch, Long64_t first, Long64_t n )
+      {
+        TLeaf* leaf = GetLeaf( branch );
+        for( Long64_t i = first; i < first+n; ++i )
+        {
+          branch->GetEntry( i );
+          column->Append( static_cast<const char*>( leaf->GetValuePointer() ) );
+        }
+      } );
+
+    if( valid ) return column;
+    delete column;
+    return 0;
+  }
+
+  //__________________________________________________________________
+  //* read all entries of a numeric branch of any type into a new double column. Returns null on error
+  ColumnDouble* ReadGenericBranch( TTree* tree, const TString& name, Long64_t nEntries )
+  {
+    ColumnDouble* column = new ColumnDouble();
+    column->SetName( name );
+    column->Reserve( nEntries );
+
+    const bool valid = ForEachTree( tree, name, nEntries, [column]( TBranch* branch, Long64_t first, Long64_t n )
+      {
+        TLeaf* leaf = GetLeaf( branch );
+        for( Long64_t i = first; i < first+n; ++i )
+        {
+          branch->GetEntry( i );
+          column->Append( leaf->GetValue( 0 ) );
+        }
+      } );
+
+    if( valid ) return column;
+    delete column;
+    return 0;
+  }
+
+  //__________________________________________________________________
+  //* values of a numeric column, as doubles. Returns false for other columns
+  bool GetValues( const ColumnBase* column, int nLines, std::vector<double>& out )
+  {
+    return TableQuery::VisitNumeric( column, [&]( const auto& values )
+      { out.assign( values.begin(), values.begin() + nLines ); } );
+  }
+
+  //__________________________________________________________________
+  //* positions and errors of a graph axis
+  class AxisValues
+  {
+    public:
+
+    //* constructor
+    AxisValues( void ):
+      fAsymmetric( false )
+    {}
+
+    //* load values, and errors from the following columns. Returns false if column is not numeric
+    bool Load( const Table& table, int column, int nLines );
+
+    //* values
+    std::vector<double> fValues;
+
+    //* low errors
+    std::vector<double> fLow;
+
+    //* high errors
+    std::vector<double> fHigh;
+
+    //* true if there are ErrorPlus or ErrorMinus columns
+    bool fAsymmetric;
+
+  };
+
+  //__________________________________________________________________
+  bool AxisValues::Load( const Table& table, int column, int nLines )
+  {
+
+    if( !GetValues( table.GetColumn( column ), nLines, fValues ) ) return false;
+    fLow.assign( nLines, 0 );
+    fHigh.assign( nLines, 0 );
+
+    // interval columns
+    const int nColumns( table.GetNColumns() );
+    if( ( table.GetColumn( column )->GetType() & ColumnBase::IntervalBegin ) &&
+      column+1 < nColumns &&
+      ( table.GetColumn( column+1 )->GetType() & ColumnBase::IntervalEnd ) )
+    {
+      std::vector<double> end;
+      if( !GetValues( table.GetColumn( column+1 ), nLines, end ) ) return false;
+      for( int i = 0; i < nLines; ++i )
+      {
+        fLow[i] = fHigh[i] = 0.5*( end[i] - fValues[i] );
+        fValues[i] += fLow[i];
+      }
+
+      return true;
+    }
+
+    // error columns, added in quadrature
+    std::vector<double> errors;
+    for( int index = column+1; index < nColumns; ++index )
+    {
+      const int type( table.GetColumn( index )->GetType() );
+      const bool symmetric( type & ColumnBase::Error );
+      const bool plus( type & ColumnBase::ErrorPlus );
+      const bool minus( type & ColumnBase::ErrorMinus );
+      if( !( symmetric || plus || minus ) ) break;
+      if( !GetValues( table.GetColumn( index ), nLines, errors ) ) break;
+
+      fAsymmetric |= ( plus || minus );
+      for( int i = 0; i < nLines; ++i )
+      {
+        const double error2( errors[i]*errors[i] );
+        if( symmetric || minus ) fLow[i] += error2;
+        if( symmetric || plus ) fHigh[i] += error2;
+      }
+    }
+
+    for( int i = 0; i < nLines; ++i )
+    {
+      fLow[i] = std::sqrt( fLow[i] );
+      fHigh[i] = std::sqrt( fHigh[i] );
+    }
+
+    return true;
+
+  }
+
+}
+
+//__________________________________________________________________
+TString TableConverter::GetBranchName( const TString& columnName )
+{
+  TString out( columnName );
+  for( int i = 0; i < out.Length(); ++i )
+  {
+    const char c( out[i] );
+    if( !( ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ) || c == '_' ) )
+    { out[i] = '_'; }
+  }
+
+  if( out.IsNull() || ( out[0] >= '0' && out[0] <= '9' ) ) out.Prepend( "c" );
+  return out;
+}
+
+//__________________________________________________________________
+TTree* TableConverter::ToTree( const Table& table, const char* name, const char* title )
+{
+
+  TTree* tree = new TTree( name, title );
+  const int nLines = table.GetNColumns() ? table.GetNLines():0;
+
+  std::set<TString> names;
+  for( int column = 0; column < table.GetNColumns(); ++column )
+  {
+
+    // unique branch name
+    const ColumnBase* base = table.GetColumn( column );
+    TString branchName( GetBranchName( base->GetName() ) );
+    if( !names.insert( branchName ).second )
+    {
+      branchName += Form( "_%i", column );
+      names.insert( branchName );
+    }
+
+    if( const ColumnDouble* typed = dynamic_cast<const ColumnDouble*>( base ) ) FillBranch<Double_t>( tree, branchName, "D", typed->GetSpan(), nLines );
+    else if( const ColumnFloat* typed = dynamic_cast<const ColumnFloat*>( base ) ) FillBranch<Float_t>( tree, branchName, "F", typed->GetSpan(), nLines );
+    else if( const ColumnInt* typed = dynamic_cast<const ColumnInt*>( base ) ) FillBranch<Int_t>( tree, branchName, "I", typed->GetSpan(), nLines );
+    else if( const ColumnBool* typed = dynamic_cast<const ColumnBool*>( base ) ) FillBranch<Bool_t>( tree, branchName, "O", typed->GetSpan(), nLines );
+    else FillStringBranch( tree, branchName, base, nLines );
+
+  }
+
+  tree->SetEntries( nLines );
+  return tree;
+
+}
+
+//__________________________________________________________________
+Table* TableConverter::FromTree( TTree* tree, const std::vector<TString>& branchNames )
+{
+
+  if( !tree ) return 0;
+
+  // table indices are integers
+  Long64_t nEntries( tree->GetEntries() );
+  if( nEntries > std::numeric_limits<int>::max() )
+  {
+    std::cout << "TableConverter::FromTree - too many entries: " << nEntries << ", truncated" << std::endl;
+    nEntries = std::numeric_limits<int>::max();
+  }
+
+  /*
+  branch names and leaf types, from the first tree of a chain. Branches are not kept,
+  since a chain deletes each tree when loading the next
+  */
+  tree->LoadTree( 0 );
+  TTree* first( tree->GetTree() );
+  if( !first )
+  {
+    std::cout << "TableConverter::FromTree - cannot load tree" << std::endl;
+    return 0;
+  }
+
+  std::vector<TBranch*> branches;
+  if( branchNames.empty() )
+  {
+    TObjArray* list( first->GetListOfBranches() );
+    for( int i = 0; i < list->GetEntriesFast(); ++i )
+    { branches.push_back( static_cast<TBranch*>( list->UncheckedAt( i ) ) ); }
+  } else {
+    for( const TString& branchName:branchNames )
+    {
+      if( TBranch* branch = first->GetBranch( branchName ) ) branches.push_back( branch );
+      else std::cout << "TableConverter::FromTree - invalid branch: " << branchName << std::endl;
+    }
+  }
+
+  std::vector< std::pair<TString, TString> > types;
+  for( TBranch* branch:branches )
+  {
+
+    TObjArray* leaves( branch->GetListOfLeaves() );
+    if( leaves->GetEntriesFast() != 1 )
+    {
+      std::cout << "TableConverter::FromTree - skipping branch " << branch->GetName() << " with " << leaves->GetEntriesFast() << " leaves" << std::endl;
+      continue;
+    }
+
+    TLeaf* leaf( GetLeaf( branch ) );
+    const TString type( leaf->GetTypeName() );
+    if( type != "Char_t" && leaf->GetLen() != 1 )
+    {
+      std::cout << "TableConverter::FromTree - skipping array branch " << branch->GetName() << std::endl;
+      continue;
+    }
+
+    types.push_back( std::make_pair( TString( branch->GetName() ), type ) );
+
+  }
+
+  // read branches one at a time, over all trees
+  Table* table = new Table();
+  for( const auto& pair:types )
+  {
+
+    const TString& name( pair.first );
+    const TString& type( pair.second );
+
+    ColumnBase* column = 0;
+    if( type == "Char_t" ) column = ReadStringBranch( tree, name, nEntries );
+    else if( type == "Double_t" ) column = ReadBranch<Double_t, ColumnDouble>( tree, name, nEntries );
+    else if( type == "Float_t" ) column = ReadBranch<Float_t, ColumnFloat>( tree, name, nEntries );
+    else if( type == "Int_t" ) column = ReadBranch<Int_t, ColumnInt>( tree, name, nEntries );
+    else if( type == "Bool_t" ) column = ReadBranch<unsigned char, ColumnBool>( tree, name, nEntries );
+    else column = ReadGenericBranch( tree, name, nEntries );
+
+    if( column ) table->AddColumn( column );
+
+  }
+
+  return table;
+
+}
+
+//__________________________________________________________________
+TGraph* TableConverter::ToGraph( const Table& table, int xColumn, int yColumn )
+{
+
+  if( !( xColumn >= 0 && xColumn < table.GetNColumns() && yColumn >= 0 && yColumn < table.GetNColumns() ) )
+  {
+    std::cout << "TableConverter::ToGraph - invalid columns " << xColumn << ", " << yColumn << std::endl;
+    return 0;
+  }
+
+  const int nLines( table.GetNLines() );
+  AxisValues x;
+  AxisValues y;
+  if( !( x.Load( table, xColumn, nLines ) && y.Load( table, yColumn, nLines ) ) )
+  {
+    std::cout << "TableConverter::ToGraph - columns " << xColumn << ", " << yColumn << " must be numeric" << std::endl;
+    return 0;
+  }
+
+  TGraph* out = 0;
+  if( x.fAsymmetric || y.fAsymmetric ) out = new TGraphAsymmErrors( nLines, x.fValues.data(), y.fValues.data(), x.fLow.data(), x.fHigh.data(), y.fLow.data(), y.fHigh.data() );
+  else out = new TGraphErrors( nLines, x.fValues.data(), y.fValues.data(), x.fLow.data(), y.fLow.data() );
+
+  out->SetName( GetBranchName( table.GetColumn( yColumn )->GetName() ) );
+  out->SetTitle( Form( ";%s;%s", table.GetColumn( xColumn )->GetName().Data(), table.GetColumn( yColumn )->GetName().Data() ) );
+  return out;
+
+}
+
+//__________________________________________________________________
+TH1* TableConverter::ToHistogram( const Table& table, int xColumn, int yColumn, const char* name )
+{
+
+  if( !( xColumn >= 0 && xColumn < table.GetNColumns() && yColumn >= 0 && yColumn < table.GetNColumns() ) )
+  {
+    std::cout << "TableConverter::ToHistogram - invalid columns " << xColumn << ", " << yColumn << std::endl;
+    return 0;
+  }
+
+  const int nLines( table.GetNLines() );
+  AxisValues x;
+  AxisValues y;
+  if( !( x.Load( table, xColumn, nLines ) && y.Load( table, yColumn, nLines ) ) )
+  {
+    std::cout << "TableConverter::ToHistogram - columns " << xColumn << ", " << yColumn << " must be numeric" << std::endl;
+    return 0;
+  }
+
+  // bin edges. Gaps between points give empty bins
+  std::vector<double> edges;
+  for( int i = 0; i < nLines; ++i )
+  {
+    const double low( x.fValues[i] - x.fLow[i] );
+    const double high( x.fValues[i] + x.fHigh[i] );
+    if( !( low < high ) || ( !edges.empty() && low < edges.back() ) )
+    {
+      std::cout << "TableConverter::ToHistogram - bins are empty or overlapping at line " << i << std::endl;
+      return 0;
+    }
+
+    if( edges.empty() || low > edges.back() ) edges.push_back( low );
+    edges.push_back( high );
+  }
+
+  if( edges.empty() )
+  {
+    std::cout << "TableConverter::ToHistogram - empty table" << std::endl;
+    return 0;
+  }
+
+  // symmetric y errors
+  std::vector<double> errors( nLines );
+  for( int i = 0; i < nLines; ++i )
+  { errors[i] = std::sqrt( 0.5*( y.fLow[i]*y.fLow[i] + y.fHigh[i]*y.fHigh[i] ) ); }
+
+  TGraphErrors graph( nLines, x.fValues.data(), y.fValues.data(), 0, errors.data() );
+  graph.SetName( name );
+  graph.SetTitle( Form( ";%s;%s", table.GetColumn( xColumn )->GetName().Data(), table.GetColumn( yColumn )->GetName().Data() ) );
+  return Utils::TGraphToHistogram( &graph, edges.size()-1, edges.data() );
+
+}
@@ -0,0 +1,71 @@
+#ifndef TableConverter_h
+#define TableConverter_h
+
+/*!
+\file    TableConverter.h
+\brief   bulk conversion between tables and ROOT trees, graphs and histograms
+*/
+
+#include <TString.h>
+
+#include <vector>
+
+class TGraph;
+class TH1;
+class TTree;
+class Table;
+
+/*!
+\class   TableConverter
+\brief   bulk conversion between tables and ROOT trees, graphs and histograms
+
+Trees are written and read one branch at a time: each branch is filled, or read, over
+all entries before moving to the next, so that only one column is touched per pass.
+Double, float, int and boolean columns map to D, F, I and O leaves. String columns map to
+C leaves. Branch names are column names with characters other than letters, digits and
+underscores replaced by underscores.
+
+Graphs and histograms use column types: the columns following a value column with
+Error, ErrorPlus or ErrorMinus flags are its errors. Several error columns of the same
+kind, for instance statistical and systematic, are added in quadrature. An IntervalBegin
+column followed by an IntervalEnd column gives the bin center and half width.
+*/
+class TableConverter
+{
+
+  public:
+
+  /*!
+  new tree with one branch per column, holding the first Table::GetNLines rows.
+  As any tree, it is attached to the current directory
+  */
+  static TTree* ToTree( const Table& table, const char* name, const char* title = "" );
+
+  /*!
+  new table with one column per branch. All top level branches are used if the list is empty.
+  Branches with more than one leaf, or with arrays other than strings, are skipped.
+  Numeric leaves of other types are stored as doubles. Branch addresses are reset.
+  For a TChain, branches and types are taken from the first tree, and entries are read
+  tree by tree. Branches missing from a later tree are skipped
+  */
+  static Table* FromTree( TTree* tree, const std::vector<TString>& branches = std::vector<TString>() );
+
+  /*!
+  graph of y column versus x column. Returns a TGraphAsymmErrors if either column has
+  ErrorPlus or ErrorMinus columns, and a TGraphErrors otherwise
+  */
+  static TGraph* ToGraph( const Table& table, int xColumn, int yColumn );
+
+  /*!
+  histogram of y column versus x column. Bin edges are given by the x errors, or by interval
+  columns, and must be increasing. Uses Utils::TGraphToHistogram. Asymmetric y errors are
+  averaged in quadrature, as in TGraphAsymmErrors::GetErrorY
+  */
+  static TH1* ToHistogram( const Table& table, int xColumn, int yColumn, const char* name = "h" );
+
+  //! branch name matching column name
+  static TString GetBranchName( const TString& columnName );
+
+};
+
+#endif
@@ -0,0 +1,307 @@
+#include "TableQuery.h"
+#include "Reduction.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <unordered_map>
+
+/*!
+  \file TableQuery.cxx
+  \brief selection, sorting, grouping and joins of tables
+*/
+
+namespace
+{
+
+  //__________________________________________________________________
+  //* number of rows used by queries
+  int GetNLines( const Table& table )
+  { return table.GetNColumns() ? table.GetNLines():0; }
+
+  //__________________________________________________________________
+  //* branch free selection of rows for which comparison is true
+  template<typename T, typename C> void Select( const ColumnSpan<T>& values, int nLines, C compare, std::vector<int>& out )
+  {
+    out.resize( nLines );
+    int n = 0;
+    for( int i = 0; i < nLines; ++i )
+    {
+      out[n] = i;
+      n += bool( compare( double( values[i] ) ) );
+    }
+    out.resize( n );
+  }
+
+  //__________________________________________________________________
+  //* group index of each row, for distinct key values in order of first appearance. Returns number of groups
+  template<typename K> int GetGroups( const std::vector<K>& keys, std::vector<int>& groups, std::vector<int>& firstRows )
+  {
+    std::unordered_map<K, int> index;
+    groups.resize( keys.size() );
+    for( size_t row = 0; row < keys.size(); ++row )
+    {
+      const auto inserted = index.insert( std::make_pair( keys[row], int( firstRows.size() ) ) );
+      if( inserted.second ) firstRows.push_back( row );
+      groups[row] = inserted.first->second;
+    }
+    return firstRows.size();
+  }
+
+  //__________________________________________________________________
+  //* key values of a column, as double for numeric columns and string otherwise. Returns false for numeric columns
+  bool GetKeys( const ColumnBase* column, int nLines, std::vector<double>& numbers, std::vector<std::string>& strings )
+  {
+    const bool numeric = TableQuery::VisitNumeric( column, [&]( const auto& values )
+      { numbers.assign( values.begin(), values.begin() + nLines ); } );
+
+    if( numeric ) return false;
+
+    strings.resize( nLines );
+    for( int row = 0; row < nLines; ++row ) strings[row] = column->GetString( row ).Data();
+    return true;
+  }
+
+  //__________________________________________________________________
+  //* name suffix for aggregate function
+  const char* GetSuffix( TableQuery::Function function )
+  {
+    switch( function )
+    {
+      case TableQuery::Sum: return "_sum";
+      case TableQuery::Mean: return "_mean";
+      case TableQuery::Min: return "_min";
+      case TableQuery::Max: return "_max";
+      default: return "_count";
+    }
+  }
+
+  //__________________________________________________________________
+  //* rows of right table matching each left row, for given keys
+  template<typename K> void Match(
+    const std::vector<K>& leftKeys, const std::vector<K>& rightKeys,
+    std::vector<int>& leftRows, std::vector<int>& rightRows )
+  {
+    // right rows per key, in order
+    std::unordered_map<K, std::vector<int> > index;
+    for( size_t row = 0; row < rightKeys.size(); ++row ) index[rightKeys[row]].push_back( row );
+
+    for( size_t row = 0; row < leftKeys.size(); ++row )
+    {
+      const auto iter = index.find( leftKeys[row] );
+      if( iter == index.end() ) continue;
+      for( const int rightRow:iter->second )
+      {
+        leftRows.push_back( row );
+        rightRows.push_back( rightRow );
+      }
+    }
+  }
+
+}
+
+//__________________________________________________________________
+std::vector<int> TableQuery::Select( const Table& table, int column, Operator op, double value )
+{
+  std::vector<int> out;
+  const int nLines = ::GetNLines( table );
+  const bool valid = column >= 0 && column < table.GetNColumns() && VisitNumeric( table.GetColumn( column ), [&]( const auto& values )
+    {
+      switch( op )
+      {
+        case Equal: ::Select( values, nLines, [value]( double x ) { return x == value; }, out ); break;
+        case NotEqual: ::Select( values, nLines, [value]( double x ) { return x != value; }, out ); break;
+        case Less: ::Select( values, nLines, [value]( double x ) { return x < value; }, out ); break;
+        case LessEqual: ::Select( values, nLines, [value]( double x ) { return x <= value; }, out ); break;
+        case Greater: ::Select( values, nLines, [value]( double x ) { return x > value; }, out ); break;
+        case GreaterEqual: ::Select( values, nLines, [value]( double x ) { return x >= value; }, out ); break;
+      }
+    } );
+
+  if( !valid ) std::cout << "TableQuery::Select - invalid column " << column << std::endl;
+  return out;
+}
+
+//__________________________________________________________________
+std::vector<int> TableQuery::And( const std::vector<int>& selection, const std::vector<int>& other )
+{
+  std::vector<int> out;
+  std::set_intersection( selection.begin(), selection.end(), other.begin(), other.end(), std::back_inserter( out ) );
+  return out;
+}
+
+//__________________________________________________________________
+Table* TableQuery::Take( const Table& table, const std::vector<int>& rows )
+{
+  Table* out = new Table();
+  for( int column = 0; column < table.GetNColumns(); ++column )
+  { out->AddColumn( table.GetColumn( column )->Take( rows ) ); }
+  return out;
+}
+
+//__________________________________________________________________
+std::vector<int> TableQuery::GetSortIndex( const Table& table, int column, bool descending )
+{
+
+  const int nLines = ::GetNLines( table );
+  std::vector<int> out( nLines );
+  for( int i = 0; i < nLines; ++i ) out[i] = i;
+  if( !( column >= 0 && column < table.GetNColumns() ) )
+  {
+    std::cout << "TableQuery::GetSortIndex - invalid column " << column << std::endl;
+    return out;
+  }
+
+  // numeric columns are compared directly, other columns through their string
+  const ColumnBase* base = table.GetColumn( column );
+  const bool numeric = VisitNumeric( base, [&]( const auto& values )
+    {
+      if( descending ) std::stable_sort( out.begin(), out.end(), [&values]( int i, int j ) { return values[j] < values[i]; } );
+      else std::stable_sort( out.begin(), out.end(), [&values]( int i, int j ) { return values[i] < values[j]; } );
+    } );
+
+  if( !numeric )
+  {
+    std::vector<std::string> values( nLines );
+    if( const ColumnString* typed = dynamic_cast<const ColumnString*>( base ) )
+    {
+      for( int i = 0; i < nLines; ++i ) values[i] = typed->GetValues()[i].Data();
+    } else {
+      for( int i = 0; i < nLines; ++i ) values[i] = base->GetString( i ).Data();
+    }
+
+    if( descending ) std::stable_sort( out.begin(), out.end(), [&values]( int i, int j ) { return values[j] < values[i]; } );
+    else std::stable_sort( out.begin(), out.end(), [&values]( int i, int j ) { return values[i] < values[j]; } );
+  }
+
+  return out;
+
+}
+
+//__________________________________________________________________
+Table* TableQuery::GroupBy( const Table& table, int keyColumn, const std::vector<Aggregate>& aggregates )
+{
+
+  if( !( keyColumn >= 0 && keyColumn < table.GetNColumns() ) )
+  {
+    std::cout << "TableQuery::GroupBy - invalid column " << keyColumn << std::endl;
+    return 0;
+  }
+
+  // groups
+  const int nLines = ::GetNLines( table );
+  std::vector<double> numbers;
+  std::vector<std::string> strings;
+  std::vector<int> groups;
+  std::vector<int> firstRows;
+  const int nGroups = GetKeys( table.GetColumn( keyColumn ), nLines, numbers, strings ) ?
+    GetGroups( strings, groups, firstRows ):
+    GetGroups( numbers, groups, firstRows );
+
+  // key column
+  Table* out = new Table();
+  out->AddColumn( table.GetColumn( keyColumn )->Take( firstRows ) );
+
+  // aggregates
+  for( const auto& aggregate:aggregates )
+  {
+
+    const ColumnBase* column = table.GetColumn( aggregate.fColumn );
+    if( !column ) continue;
+
+    const TString name( column->GetName() + GetSuffix( aggregate.fFunction ) );
+    std::vector<int> counts( nGroups, 0 );
+    for( int row = 0; row < nLines; ++row ) ++counts[groups[row]];
+
+    if( aggregate.fFunction == Count )
+    {
+      out->AddColumn( new ColumnInt( name.Data(), counts.data(), nGroups ) );
+      continue;
+    }
+
+    std::vector<double> values( nGroups, 0 );
+    const bool numeric = VisitNumeric( column, [&]( const auto& span )
+      {
+        switch( aggregate.fFunction )
+        {
+          case Min:
+          std::fill( values.begin(), values.end(), std::numeric_limits<double>::infinity() );
+          for( int row = 0; row < nLines; ++row ) values[groups[row]] = std::min<double>( values[groups[row]], span[row] );
+          break;
+
+          case Max:
+          std::fill( values.begin(), values.end(), -std::numeric_limits<double>::infinity() );
+          for( int row = 0; row < nLines; ++row ) values[groups[row]] = std::max<double>( values[groups[row]], span[row] );
+          break;
+
+          default:
+          {
+            std::vector<Reduction::Accumulator> sums( nGroups );
+            for( int row = 0; row < nLines; ++row ) sums[groups[row]].Add( span[row] );
+            for( int group = 0; group < nGroups; ++group )
+            {
+              values[group] = sums[group].Get();
+              if( aggregate.fFunction == Mean ) values[group] /= counts[group];
+            }
+            break;
+          }
+        }
+      } );
+
+    if( !numeric )
+    {
+      std::cout << "TableQuery::GroupBy - column " << aggregate.fColumn << " is not numeric" << std::endl;
+      continue;
+    }
+
+    // integer and boolean formats do not apply to double values
+    const bool floating( dynamic_cast<const ColumnDouble*>( column ) || dynamic_cast<const ColumnFloat*>( column ) );
+    const TString format( floating ? column->GetFormat():TString( "%f" ) );
+    out->AddColumn( new ColumnDouble( name.Data(), values.data(), nGroups, format.Data(), column->GetType() ) );
+
+  }
+
+  return out;
+
+}
+
+//__________________________________________________________________
+Table* TableQuery::Join( const Table& left, int leftKey, const Table& right, int rightKey )
+{
+
+  if( !( leftKey >= 0 && leftKey < left.GetNColumns() && rightKey >= 0 && rightKey < right.GetNColumns() ) )
+  {
+    std::cout << "TableQuery::Join - invalid key columns " << leftKey << ", " << rightKey << std::endl;
+    return 0;
+  }
+
+  // keys
+  std::vector<double> leftNumbers;
+  std::vector<double> rightNumbers;
+  std::vector<std::string> leftStrings;
+  std::vector<std::string> rightStrings;
+  const bool leftIsString = GetKeys( left.GetColumn( leftKey ), ::GetNLines( left ), leftNumbers, leftStrings );
+  const bool rightIsString = GetKeys( right.GetColumn( rightKey ), ::GetNLines( right ), rightNumbers, rightStrings );
+  if( leftIsString != rightIsString )
+  {
+    std::cout << "TableQuery::Join - key columns have different types" << std::endl;
+    return 0;
+  }
+
+  // matching rows
+  std::vector<int> leftRows;
+  std::vector<int> rightRows;
+  if( leftIsString ) Match( leftStrings, rightStrings, leftRows, rightRows );
+  else Match( leftNumbers, rightNumbers, leftRows, rightRows );
+
+  // columns
+  Table* out = Take( left, leftRows );
+  for( int column = 0; column < right.GetNColumns(); ++column )
+  {
+    if( column == rightKey ) continue;
+    out->AddColumn( right.GetColumn( column )->Take( rightRows ) );
+  }
+
+  return out;
+
+}
@@ -0,0 +1,146 @@
+#ifndef TableQuery_h
+#define TableQuery_h
+
+/*!
+\file    TableQuery.h
+\brief   selection, sorting, grouping and joins of tables
+*/
+
+#include "Table.h"
+
+#include <vector>
+
+/*!
+\class   TableQuery
+\brief   selection, sorting, grouping and joins of tables
+
+Operators work column-wise. Numeric columns are read through ColumnSpan, with no copy
+for double columns. Row selections are vectors of row indices. Selection loops are
+branch free: every row index is written, and the output position only advances for
+selected rows.
+
+Operators that return a Table create a new table, owned by the caller. Its columns are
+built with ColumnBase::Take, so they keep the type, name, format and flags of the input
+columns. Only the first Table::GetNLines rows of each column are used.
+*/
+class TableQuery
+{
+
+  public:
+
+  //! comparison operators
+  enum Operator
+  {
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual
+  };
+
+  //! aggregate functions
+  enum Function
+  {
+    Sum,
+    Mean,
+    Min,
+    Max,
+    Count
+  };
+
+  //! aggregate: function applied to a column, per group
+  class Aggregate
+  {
+    public:
+
+    //! constructor
+    Aggregate( int column, Function function ):
+      fColumn( column ),
+      fFunction( function )
+    {}
+
+    //! column
+    int fColumn;
+
+    //! function
+    Function fFunction;
+
+  };
+
+  //! rows for which numeric column compares to value
+  static std::vector<int> Select( const Table& table, int column, Operator op, double value );
+
+  //! rows for which predicate is true for numeric column value
+  template<typename F> static std::vector<int> Select( const Table& table, int column, F predicate );
+
+  //! rows of selection that are also in other. Both must be sorted
+  static std::vector<int> And( const std::vector<int>& selection, const std::vector<int>& other );
+
+  //! new table with given rows, in order
+  static Table* Take( const Table& table, const std::vector<int>& rows );
+
+  //! new table with rows for which numeric column compares to value
+  static Table* Filter( const Table& table, int column, Operator op, double value )
+  { return Take( table, Select( table, column, op, value ) ); }
+
+  //! row order that sorts column. Sort is stable
+  static std::vector<int> GetSortIndex( const Table& table, int column, bool descending = false );
+
+  //! new table sorted on column. Sort is stable
+  static Table* Sort( const Table& table, int column, bool descending = false )
+  { return Take( table, GetSortIndex( table, column, descending ) ); }
+
+  /*!
+  new table with one row per distinct value of key column, in order of first appearance.
+  First column is the key, followed by one double column per aggregate, named after
+  the aggregated column and the function, for instance "x_mean". Count gives an int column.
+  Aggregates apply to numeric columns
+  */
+  static Table* GroupBy( const Table& table, int keyColumn, const std::vector<Aggregate>& aggregates );
+
+  /*!
+  inner join on key columns, which must be both numeric or both strings.
+  Output rows follow left rows, then matching right rows, in order.
+  Columns are all left columns followed by right columns other than the key
+  */
+  static Table* Join( const Table& left, int leftKey, const Table& right, int rightKey );
+
+  //! call function with the span of a numeric column. Returns false for other columns
+  template<typename F> static bool VisitNumeric( const ColumnBase* column, F function );
+
+};
+
+//__________________________________________________________________
+template<typename F> bool TableQuery::VisitNumeric( const ColumnBase* column, F function )
+{
+  if( const ColumnDouble* typed = dynamic_cast<const ColumnDouble*>( column ) ) function( typed->GetSpan() );
+  else if( const ColumnFloat* typed = dynamic_cast<const ColumnFloat*>( column ) ) function( typed->GetSpan() );
+  else if( const ColumnInt* typed = dynamic_cast<const ColumnInt*>( column ) ) function( typed->GetSpan() );
+  else if( const ColumnBool* typed = dynamic_cast<const ColumnBool*>( column ) ) function( typed->GetSpan() );
+  else return false;
+  return true;
+}
+
+//__________________________________________________________________
+template<typename F> std::vector<int> TableQuery::Select( const Table& table, int column, F predicate )
+{
+  std::vector<int> out;
+  const int nLines = table.GetNColumns() ? table.GetNLines():0;
+  const bool valid = column >= 0 && column < table.GetNColumns() && VisitNumeric( table.GetColumn( column ), [&]( const auto& values )
+    {
+      out.resize( nLines );
+      int n = 0;
+      for( int i = 0; i < nLines; ++i )
+      {
+        out[n] = i;
+        n += bool( predicate( double( values[i] ) ) );
+      }
+      out.resize( n );
+    } );
+
+  if( !valid ) std::cout << "TableQuery::Select - invalid column " << column << std::endl;
+  return out;
+}
+
+#endif
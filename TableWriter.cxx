@@ -0,0 +1,470 @@
+#include "TableWriter.h"
+#include "Table.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/*!
+  \file TableWriter.cxx
+  \brief buffered text, latex and hepdata output of tables
+*/
+
+namespace
+{
+
+  //* default printf precision
+  const int defaultPrecision = 6;
+
+  //* format a value with snprintf, appended to out
+  template<typename T> void AppendFormatted( std::string& out, const char* format, T value )
+  {
+    char buffer[128];
+    const int size = snprintf( buffer, sizeof( buffer ), format, value );
+    if( size < 0 ) return;
+    if( size < int( sizeof( buffer ) ) ) out.append( buffer, size );
+    else {
+      const size_t offset = out.size();
+      out.resize( offset + size + 1 );
+      snprintf( &out[offset], size + 1, format, value );
+      out.resize( offset + size );
+    }
+  }
+
+  //* format a floating point value as printf would with %f, %e or %g, appended to out
+  void AppendFloating( std::string& out, char conversion, int precision, double value )
+  {
+    const std::chars_format format =
+      conversion == 'f' ? std::chars_format::fixed:
+      conversion == 'e' ? std::chars_format::scientific:
+      std::chars_format::general;
+
+    char buffer[128];
+    const std::to_chars_result result = std::to_chars( buffer, buffer + sizeof( buffer ), value, format, precision );
+    if( result.ec == std::errc() ) out.append( buffer, result.ptr - buffer );
+    else {
+      // value too long for buffer
+      const char formatString[] = { '%', '.', '*', conversion, 0 };
+      char* tmp = 0;
+      const int size = asprintf( &tmp, formatString, precision, value );
+      if( size >= 0 ) out.append( tmp, size );
+      free( tmp );
+    }
+  }
+
+  //* format an integer value as printf would with %d, appended to out
+  void AppendInteger( std::string& out, int value )
+  {
+    char buffer[16];
+    const std::to_chars_result result = std::to_chars( buffer, buffer + sizeof( buffer ), value );
+    out.append( buffer, result.ptr - buffer );
+  }
+
+}
+
+//__________________________________________________________________
+TableWriter::CellFormat::CellFormat( const ColumnBase* column ):
+  fColumn( column ),
+  fType( column->GetType() ),
+  fName( column->GetName().Data() ),
+  fKind( Other ),
+  fValues( 0 ),
+  fFormat( column->GetFormat().Data() ),
+  fFast( false ),
+  fConversion( 0 ),
+  fPrecision( defaultPrecision )
+{
+
+  // value storage
+  if( const ColumnDouble* typed = dynamic_cast<const ColumnDouble*>( column ) ) { fKind = Double; fValues = typed->GetValues().data(); }
+  else if( const ColumnFloat* typed = dynamic_cast<const ColumnFloat*>( column ) ) { fKind = Float; fValues = typed->GetValues().data(); }
+  else if( const ColumnInt* typed = dynamic_cast<const ColumnInt*>( column ) ) { fKind = Int; fValues = typed->GetValues().data(); }
+  else if( const ColumnBool* typed = dynamic_cast<const ColumnBool*>( column ) ) { fKind = Bool; fValues = typed->GetValues().data(); }
+  else if( const ColumnString* typed = dynamic_cast<const ColumnString*>( column ) ) { fKind = String; fValues = typed->GetValues().data(); }
+
+  // fast formatting for plain %f, %e, %g, with optional precision, and %d
+  const char* cursor = fFormat.c_str();
+  if( *cursor++ != '%' ) return;
+
+  bool hasPrecision = false;
+  if( *cursor == '.' )
+  {
+    hasPrecision = true;
+    ++cursor;
+    fPrecision = 0;
+    if( !( *cursor >= '0' && *cursor <= '9' ) ) return;
+    while( *cursor >= '0' && *cursor <= '9' ) fPrecision = 10*fPrecision + ( *cursor++ - '0' );
+    if( fPrecision > 100 ) return;
+  }
+
+  if( fKind == Double || fKind == Float )
+  {
+
+    if( *cursor == 'l' ) ++cursor;
+    if( *cursor != 'f' && *cursor != 'e' && *cursor != 'g' ) return;
+    fConversion = *cursor++;
+    fFast = !*cursor;
+
+  } else if( fKind == Int || fKind == Bool ) {
+
+    if( hasPrecision ) return;
+    if( *cursor != 'd' && *cursor != 'i' ) return;
+    fConversion = *cursor++;
+    fFast = !*cursor;
+
+  }
+
+}
+
+//__________________________________________________________________
+TableWriter::TableWriter( const Table& table, std::ostream& out, Format format ):
+  fTable( table ),
+  fOut( out ),
+  fFormat( format ),
+  fNLines( 0 )
+{ Update(); }
+
+//__________________________________________________________________
+TableWriter::~TableWriter( void )
+{ Flush(); }
+
+//__________________________________________________________________
+void TableWriter::Update( void )
+{
+
+  fCells.clear();
+  for( std::vector< ColumnBase* >::const_iterator iter = fTable.fColumns.begin(); iter != fTable.fColumns.end(); iter++ )
+  { fCells.push_back( CellFormat( *iter ) ); }
+
+  fNLines = fTable.fColumns.empty() ? 0:fTable.GetNLines();
+
+}
+
+//__________________________________________________________________
+void TableWriter::WriteHeader( void )
+{
+
+  const bool skipHeader( fTable.fFlags & Table::SkipHeader );
+  switch( fFormat )
+  {
+
+    case Text:
+    if( !skipHeader )
+    {
+      for( size_t column = 0; column < fCells.size(); column++ )
+      {
+        if( column != 0 ) Append( "   " );
+        Append( fCells[column].fName );
+      }
+
+      Append( "\n" );
+    }
+    break;
+
+    case Latex:
+    if( !skipHeader )
+    {
+      Append( "\\begin{tabular}{" );
+
+      bool first = true;
+      for( size_t column = 0; column < fCells.size(); column++ )
+      {
+        if( fCells[column].fType & ColumnBase::HasHeader )
+        {
+          if( !first ) Append( "|" );
+          first = false;
+          Append( fCells[column].fColumn->GetAlignment().Data() );
+        }
+      }
+
+      Append( "}\n" );
+
+      for( size_t column = 0; column < fCells.size(); column++ )
+      {
+        if( !( fCells[column].fType & ColumnBase::HasHeader ) ) continue;
+        if( column != 0 ) Append( " & " );
+        Append( fCells[column].fName );
+      }
+
+      Append( "\\\\\n" );
+    }
+
+    Append( "\\hline\n" );
+    break;
+
+    case Hep:
+    if( !skipHeader ) Append( "*dataset:\n" );
+    break;
+
+  }
+
+  CheckFlush();
+
+}
+
+//__________________________________________________________________
+void TableWriter::WriteRows( int firstLine, int lastLine )
+{
+
+  lastLine = std::min( lastLine, fNLines );
+  for( int line = firstLine; line < lastLine; line++ )
+  {
+    switch( fFormat )
+    {
+      case Text: WriteTextRow( line ); break;
+      case Latex: WriteLatexRow( line ); break;
+      case Hep: WriteHepRow( line ); break;
+    }
+
+    CheckFlush();
+  }
+
+}
+
+//__________________________________________________________________
+void TableWriter::WriteTrailer( void )
+{
+
+  const bool skipTrailer( fTable.fFlags & Table::SkipTrailer );
+  switch( fFormat )
+  {
+    case Text: break;
+
+    case Latex:
+    if( !skipTrailer ) Append( "\\end{tabular}\n\n" );
+    break;
+
+    case Hep:
+    if( !skipTrailer ) Append( "*dataend:\n\n" );
+    break;
+  }
+
+  Flush();
+
+}
+
+//__________________________________________________________________
+void TableWriter::Flush( void )
+{
+  if( fBuffer.empty() ) return;
+  fOut.write( fBuffer.data(), fBuffer.size() );
+  fOut.flush();
+  fBuffer.clear();
+}
+
+//__________________________________________________________________
+void TableWriter::FormatCell( const CellFormat& format, int line )
+{
+
+  fCell.clear();
+  switch( format.fKind )
+  {
+
+    case Double:
+    {
+      const double value = static_cast<const double*>( format.fValues )[line];
+      if( format.fFast ) AppendFloating( fCell, format.fConversion, format.fPrecision, value );
+      else AppendFormatted( fCell, format.fFormat.c_str(), value );
+      break;
+    }
+
+    case Float:
+    {
+      const double value = static_cast<const float*>( format.fValues )[line];
+      if( format.fFast ) AppendFloating( fCell, format.fConversion, format.fPrecision, value );
+      else AppendFormatted( fCell, format.fFormat.c_str(), value );
+      break;
+    }
+
+    case Int:
+    {
+      const int value = static_cast<const int*>( format.fValues )[line];
+      if( format.fFast ) AppendInteger( fCell, value );
+      else AppendFormatted( fCell, format.fFormat.c_str(), value );
+      break;
+    }
+
+    case Bool:
+    {
+      const int value = static_cast<const unsigned char*>( format.fValues )[line];
+      if( format.fFast ) AppendInteger( fCell, value );
+      else AppendFormatted( fCell, format.fFormat.c_str(), value );
+      break;
+    }
+
+    case String:
+    fCell.append( static_cast<const TString*>( format.fValues )[line].Data() );
+    break;
+
+    default:
+    fCell.append( format.fColumn->GetString( line ).Data() );
+    break;
+
+  }
+
+}
+
+//__________________________________________________________________
+void TableWriter::ReplaceAll( const char* c1, const char* c2 )
+{
+
+  const size_t length = strlen( c1 );
+  fScratch.clear();
+  size_t current = 0;
+  size_t found = 0;
+  while( current < fCell.size() && ( found = fCell.find( c1, current ) ) != std::string::npos )
+  {
+    fScratch.append( fCell, current, found-current );
+    fScratch.append( c2 );
+    current = found + length;
+  }
+
+  if( current < fCell.size() ) fScratch.append( fCell, current, std::string::npos );
+  fCell.swap( fScratch );
+
+}
+
+//__________________________________________________________________
+void TableWriter::AppendCell( const CellFormat& format, int line )
+{
+  FormatCell( format, line );
+  Append( fCell );
+}
+
+//__________________________________________________________________
+void TableWriter::WriteTextRow( int line )
+{
+
+  for( size_t column = 0; column < fCells.size(); column++ )
+  {
+
+    const CellFormat& format( fCells[column] );
+    FormatCell( format, line );
+
+    // convert exp to text format. Exponent markers all contain 'e'
+    bool hasExponent = false;
+    if( fCell.find( 'e' ) != std::string::npos )
+    {
+      while( fCell.find( "e-0" ) != std::string::npos ) ReplaceAll( "e-0", "e-" );
+      while( fCell.find( "e0" ) != std::string::npos ) ReplaceAll( "e0", "e" );
+      hasExponent = fCell.find( 'e' ) != std::string::npos;
+    }
+
+    // print column
+    if( hasExponent ) ReplaceAll( "e", " 10^" );
+    else if( format.fType & ColumnBase::HasHeader ) Append( "   " );
+    if( format.fType == ColumnBase::IntervalBegin ) Append( "[" );
+    if( format.fType == ColumnBase::IntervalEnd ) Append( " , " );
+    if( format.fType == ColumnBase::Error ) Append( " +/- " );
+    if( format.fType == ColumnBase::ErrorPlus ) Append( " +" );
+    if( format.fType == ColumnBase::ErrorMinus ) Append( " -" );
+    Append( fCell );
+    if( format.fType == ColumnBase::IntervalEnd ) Append( "]" );
+
+  }
+
+  if( !( fTable.fFlags & Table::SkipTrailer ) ) Append( "\n" );
+
+}
+
+//__________________________________________________________________
+void TableWriter::WriteLatexRow( int line )
+{
+
+  for( size_t column = 0; column < fCells.size(); column++ )
+  {
+
+    const CellFormat& format( fCells[column] );
+    FormatCell( format, line );
+
+    // convert exp to latex format. Exponent markers all contain 'e'
+    if( fCell.find( 'e' ) != std::string::npos )
+    {
+      while( fCell.find( "e-0" ) != std::string::npos ) ReplaceAll( "e-0", "e-" );
+      while( fCell.find( "e0" ) != std::string::npos ) ReplaceAll( "e0", "e" );
+      if( fCell.find( 'e' ) != std::string::npos )
+      {
+        ReplaceAll( "e", "\\;10^{" );
+        fCell.append( "}" );
+      }
+    }
+
+    // print column
+    if( column == 0 ) Append( "$" );
+    else if( format.fType & ColumnBase::HasHeader ) Append( "$ & $" );
+    if( format.fType == ColumnBase::IntervalBegin ) Append( "[" );
+    if( format.fType == ColumnBase::IntervalEnd ) Append( " , " );
+    if( format.fType == ColumnBase::Error ) Append( " \\pm " );
+    if( format.fType == ColumnBase::ErrorPlus ) Append( "^{+" );
+    if( format.fType == ColumnBase::ErrorMinus ) Append( "_{-" );
+    if( format.fType == ColumnBase::ErrorRel ) Append( "\\;(" );
+    Append( fCell );
+    if( format.fType == ColumnBase::ErrorPlus ) Append( "}" );
+    if( format.fType == ColumnBase::ErrorMinus ) Append( "}" );
+    if( format.fType == ColumnBase::IntervalEnd ) Append( "]" );
+    if( format.fType == ColumnBase::ErrorRel ) Append( "\\%)" );
+
+  }
+
+  Append( "$ \\\\\n" );
+
+  if( fTable.fHorizontalLines.find( line+1 ) != fTable.fHorizontalLines.end() )
+  { Append( "\\hline\n" ); }
+
+}
+
+//__________________________________________________________________
+void TableWriter::WriteHepRow( int line )
+{
+
+  bool foundSyst( false );
+  bool hasSyst( false );
+  for( size_t column = 0; column < fCells.size(); column++ )
+  {
+
+    const CellFormat& format( fCells[column] );
+    const int type = format.fType;
+
+    // formats
+    if( type & ColumnBase::ErrorSyst && !hasSyst )
+    {
+      foundSyst = true;
+      Append( " (DSYS=" );
+    }
+
+    if( type & ColumnBase::ErrorPlus )
+    {
+      if( type & ColumnBase::ErrorSyst && hasSyst ) Append( "; DSYS=" );
+      Append( " +" );
+    }
+    else if( type & ColumnBase::ErrorMinus ) Append( " , -" );
+    else if( type & ColumnBase::Error )
+    {
+      if( type & ColumnBase::ErrorStat ) Append( " +- " );
+      else if( type & ColumnBase::ErrorSyst && hasSyst ) Append( "; DSYS=" );
+    }
+    else if( type & ColumnBase::IntervalEnd ) Append( " TO " );
+    else if( column > 0 ) Append( "; " );
+
+    // value
+    AppendCell( format, line );
+
+    // trailer
+    if( ( type & ( ColumnBase::Error|ColumnBase::ErrorMinus ) ) &&
+      ( type & ColumnBase::ErrorSyst ) &&
+      !format.fName.empty() )
+    {
+      Append( ":" );
+      Append( format.fName );
+    }
+
+    if( foundSyst ) hasSyst = true;
+
+  }
+
+  if( hasSyst ) Append( ");\n" );
+  else Append( ";\n" );
+
+}
@@ -0,0 +1,177 @@
+#ifndef TableWriter_h
+#define TableWriter_h
+
+/*!
+\file    TableWriter.h
+\brief   buffered text, latex and hepdata output of tables
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+class ColumnBase;
+class Table;
+
+/*!
+\class   TableWriter
+\brief   buffered text, latex and hepdata output of tables
+
+Rows are formatted into a reusable buffer, which is written to the output stream
+whenever it exceeds a fixed size. Numbers are formatted with std::to_chars when the
+column format is a plain %f, %e, %g or %d conversion, with optional precision, and
+with snprintf otherwise. Both give the same characters as the Form call used by
+ColumnBase::GetString.
+
+The number of lines is computed once, on construction. Rows can be written in several
+calls to WriteRows, for instance while the table is being filled, after calling Update.
+The output is identical to that of Table::PrintText, PrintLatex and PrintHep.
+*/
+class TableWriter
+{
+
+  public:
+
+  //! output format
+  enum Format
+  {
+    Text,
+    Latex,
+    Hep
+  };
+
+  //! constructor
+  TableWriter( const Table& table, std::ostream& out, Format format );
+
+  //! destructor. Flushes buffer
+  ~TableWriter( void );
+
+  //! refresh number of lines and column storage, after the table has changed
+  void Update( void );
+
+  //! number of lines, as of construction or last update
+  int GetNLines( void ) const
+  { return fNLines; }
+
+  //! write header, unless table flags skip it
+  void WriteHeader( void );
+
+  //! write rows in [firstLine, lastLine). Last line is clamped to the number of lines
+  void WriteRows( int firstLine, int lastLine );
+
+  //! write trailer, unless table flags skip it
+  void WriteTrailer( void );
+
+  //! write buffer to output stream
+  void Flush( void );
+
+  private:
+
+  //! value storage
+  enum Kind
+  {
+    Double,
+    Float,
+    Int,
+    Bool,
+    String,
+    Other
+  };
+
+  //! column description, with direct access to values
+  class CellFormat
+  {
+    public:
+
+    //! constructor
+    CellFormat( const ColumnBase* column );
+
+    //! column
+    const ColumnBase* fColumn;
+
+    //! column type flags
+    int fType;
+
+    //! column name
+    std::string fName;
+
+    //! value storage
+    Kind fKind;
+
+    //! values
+    const void* fValues;
+
+    //! format
+    std::string fFormat;
+
+    //! true if values can be formatted with to_chars
+    bool fFast;
+
+    //! conversion character, for fast formatting
+    char fConversion;
+
+    //! precision, for fast formatting
+    int fPrecision;
+
+  };
+
+  //! append formatted cell to buffer
+  void AppendCell( const CellFormat& format, int line );
+
+  //! format cell into fCell, with exponent conversion
+  void FormatCell( const CellFormat& format, int line );
+
+  //! replace all occurrences of c1 by c2 in fCell, as Stream::ReplaceAll
+  void ReplaceAll( const char* c1, const char* c2 );
+
+  //! write text row
+  void WriteTextRow( int line );
+
+  //! write latex row
+  void WriteLatexRow( int line );
+
+  //! write hepdata row
+  void WriteHepRow( int line );
+
+  //! append string to buffer
+  void Append( const char* value )
+  { fBuffer.append( value ); }
+
+  //! append string to buffer
+  void Append( const std::string& value )
+  { fBuffer.append( value ); }
+
+  //! flush if buffer is large enough
+  void CheckFlush( void )
+  { if( fBuffer.size() >= fFlushSize ) Flush(); }
+
+  //! buffer size above which it is written to stream
+  static const size_t fFlushSize = 1<<20;
+
+  //! table
+  const Table& fTable;
+
+  //! output stream
+  std::ostream& fOut;
+
+  //! format
+  Format fFormat;
+
+  //! number of lines
+  int fNLines;
+
+  //! column formats
+  std::vector<CellFormat> fCells;
+
+  //! output buffer
+  std::string fBuffer;
+
+  //! current cell
+  std::string fCell;
+
+  //! scratch string used for replacements
+  std::string fScratch;
+
+};
+
+#endif
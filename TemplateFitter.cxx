@@ -0,0 +1,379 @@
+#include "TemplateFitter.h"
+#include "Utils.h"
+
+#include <TH1.h>
+#include <TMath.h>
+#include <TMinuit.h>
+
+#include <iostream>
+
+/*!
+  \file TemplateFitter.cxx
+  \brief binned fit of a histogram to a linear combination of template histograms
+*/
+
+//__________________________________
+TemplateFitter* TemplateFitter::fCurrent = 0;
+
+//__________________________________________________________________
+TemplateFitter::TemplateFitter( TH1* h, TString option ):
+  fHistogram( h ),
+  fOption( option ),
+  fLikelihood( option.Contains( "L" ) ),
+  fBarlowBeeston( !option.Contains( "N" ) ),
+  fStride( 0 ),
+  fFcn( 0 ),
+  fNFitPoints( 0 )
+{}
+
+//___________________________
+TemplateFitter::~TemplateFitter( void )
+{ if( fCurrent == this ) fCurrent = 0; }
+
+//__________________________________________________________________
+int TemplateFitter::AddTemplate( TH1* h, TString name )
+{
+
+  if( !h )
+  {
+    std::cout << "TemplateFitter::AddTemplate - template not set" << std::endl;
+    return -1;
+  }
+
+  fTemplates.push_back( h );
+  fNames.push_back( name.IsNull() ? TString( h->GetName() ):name );
+  fInitial.push_back( 0 );
+  fInitialSet.push_back( false );
+  fFixed.push_back( false );
+  return fTemplates.size()-1;
+
+}
+
+//__________________________________________________________________
+void TemplateFitter::SetParameter( int i, double value )
+{
+  if( i < 0 || i >= int(fTemplates.size()) ) return;
+  fInitial[i] = value;
+  fInitialSet[i] = true;
+}
+
+//__________________________________________________________________
+void TemplateFitter::FixParameter( int i, double value )
+{
+  if( i < 0 || i >= int(fTemplates.size()) ) return;
+  fInitial[i] = value;
+  fInitialSet[i] = true;
+  fFixed[i] = true;
+}
+
+//__________________________________________________________________
+int TemplateFitter::GetNDF( void ) const
+{
+  int out = fNFitPoints;
+  for( unsigned int i = 0; i < fFixed.size(); ++i )
+  { if( !fFixed[i] ) --out; }
+  return out;
+}
+
+//__________________________________________________________________
+bool TemplateFitter::Initialize( void )
+{
+
+  fBins.clear();
+  fData.clear();
+  fDataVariance.clear();
+
+  // fitted bins, from data axis ranges
+  for( int binX = fHistogram->GetXaxis()->GetFirst(); binX <= fHistogram->GetXaxis()->GetLast(); ++binX )
+    for( int binY = fHistogram->GetYaxis()->GetFirst(); binY <= fHistogram->GetYaxis()->GetLast(); ++binY )
+    for( int binZ = fHistogram->GetZaxis()->GetFirst(); binZ <= fHistogram->GetZaxis()->GetLast(); ++binZ )
+  {
+    const int bin( fHistogram->GetBin( binX, binY, binZ ) );
+    const double error( fHistogram->GetBinError( bin ) );
+    if( !fLikelihood && error <= 0 ) continue;
+
+    fBins.push_back( bin );
+    fData.push_back( fHistogram->GetBinContent( bin ) );
+    fDataVariance.push_back( error*error );
+  }
+
+  const int nBins = fBins.size();
+  if( !nBins )
+  {
+    std::cout << "TemplateFitter::Initialize - no bins to fit" << std::endl;
+    return false;
+  }
+
+  // pad rows to a multiple of 8 doubles, so that each row starts on a cache line boundary
+  // relative to the first one
+  fStride = 8*((nBins+7)/8);
+  const int nTemplates = fTemplates.size();
+  fContent.assign( nTemplates*fStride, 0 );
+  fContentVariance.assign( nTemplates*fStride, 0 );
+  fPrediction.assign( fStride, 0 );
+  fVariance.assign( fStride, 0 );
+
+  for( int iT = 0; iT < nTemplates; ++iT )
+  {
+
+    TH1* h = fTemplates[iT];
+    if( h->GetNcells() != fHistogram->GetNcells() )
+    {
+      std::cout << "TemplateFitter::Initialize - binning of template " << fNames[iT] << " does not match data" << std::endl;
+      return false;
+    }
+
+    double* content = &fContent[iT*fStride];
+    double* variance = &fContentVariance[iT*fStride];
+    double sum = 0;
+    for( int i = 0; i < nBins; ++i )
+    {
+      const double error( h->GetBinError( fBins[i] ) );
+      sum += ( content[i] = h->GetBinContent( fBins[i] ) );
+      variance[i] = error*error;
+    }
+
+    if( sum <= 0 )
+    {
+      std::cout << "TemplateFitter::Initialize - template " << fNames[iT] << " is empty in fit range" << std::endl;
+      return false;
+    }
+
+    // normalize
+    for( int i = 0; i < nBins; ++i )
+    {
+      content[i] /= sum;
+      variance[i] /= sum*sum;
+    }
+
+  }
+
+  return true;
+
+}
+
+//__________________________________________________________________
+void TemplateFitter::Predict( const double* par ) const
+{
+
+  const int nBins = fBins.size();
+  const int nTemplates = fTemplates.size();
+
+  double* prediction = &fPrediction[0];
+  double* variance = &fVariance[0];
+  for( int i = 0; i < nBins; ++i ) prediction[i] = variance[i] = 0;
+
+  for( int iT = 0; iT < nTemplates; ++iT )
+  {
+    const double yield = par[iT];
+    const double yield2 = yield*yield;
+    const double* content = &fContent[iT*fStride];
+    const double* contentVariance = &fContentVariance[iT*fStride];
+    for( int i = 0; i < nBins; ++i )
+    {
+      prediction[i] += yield*content[i];
+      variance[i] += yield2*contentVariance[i];
+    }
+  }
+
+}
+
+//__________________________________________________________________
+double TemplateFitter::GetScaleFactor( int i, double& relVariance ) const
+{
+
+  // relative variance of the prediction
+  const double predicted = fPrediction[i];
+  relVariance = ( fBarlowBeeston && predicted > 0 ) ? fVariance[i]/(predicted*predicted):0;
+  if( relVariance <= 0 ) return 1;
+
+  // scale factor minimizing the bin contribution
+  const double measured = fData[i];
+  if( fLikelihood )
+  {
+
+    // positive root of beta^2 + (mu s - 1) beta - n s = 0
+    const double b = TMath::Max( predicted, 1e-9 )*relVariance - 1;
+    const double c = 4*TMath::Max( measured, 0. )*relVariance;
+    const double root = TMath::Sqrt( b*b + c );
+    return TMath::Max( b > 0 ? c/( 2*( b + root ) ):( root - b )/2, 1e-9 );
+
+  } else {
+
+    const double dataVariance = fDataVariance[i];
+    return ( predicted*measured*relVariance + dataVariance )/( predicted*predicted*relVariance + dataVariance );
+
+  }
+
+}
+
+//__________________________________________________________________
+double TemplateFitter::Evaluate( const double* par )
+{
+
+  Predict( par );
+
+  const int nBins = fBins.size();
+  double out = 0;
+  for( int i = 0; i < nBins; ++i )
+  {
+
+    double relVariance = 0;
+    const double beta = GetScaleFactor( i, relVariance );
+    if( relVariance > 0 ) out += ( beta - 1 )*( beta - 1 )/relVariance;
+
+    const double measured = fData[i];
+    if( fLikelihood )
+    {
+
+      const double mu = beta*TMath::Max( fPrediction[i], 1e-9 );
+      out += 2*( mu - measured );
+      if( measured > 0 ) out += 2*measured*TMath::Log( measured/mu );
+
+    } else {
+
+      const double delta = measured - beta*fPrediction[i];
+      out += delta*delta/fDataVariance[i];
+
+    }
+
+  }
+
+  return out;
+
+}
+
+//__________________________________________________________________
+int TemplateFitter::Fit( void )
+{
+
+  if( !fHistogram || fTemplates.empty() )
+  {
+    std::cout << "TemplateFitter::Fit - histogram or templates not set" << std::endl;
+    return -1;
+  }
+
+  if( !Initialize() ) return -1;
+
+  const bool quiet( fOption.Contains( "Q" ) );
+  const int nPar = fTemplates.size();
+  const int nBins = fBins.size();
+
+  if( !quiet )
+  { std::cout << "TemplateFitter::Fit - templates: " << nPar << " bins: " << nBins << std::endl; }
+
+  // default initial yields
+  double sum = 0;
+  for( int i = 0; i < nBins; ++i ) sum += fData[i];
+
+  TMinuit minuit( nPar );
+  minuit.SetPrintLevel( -1 );
+
+  int error = 0;
+  double arglist[2] = { 1, 0 };
+  minuit.mnexcm( "SET NOW", arglist, 0, error );
+
+  // errors correspond to one unit of chisquare or -2 log(L)
+  minuit.mnexcm( "SET ERR", arglist, 1, error );
+
+  for( int iP = 0; iP < nPar; ++iP )
+  {
+
+    const double value = fInitialSet[iP] ? fInitial[iP]:sum/nPar;
+    const double step = value ? 0.1*TMath::Abs( value ):1;
+    minuit.mnparm( iP, fNames[iP], value, step, 0, 0, error );
+    if( error ) std::cout << "TemplateFitter::Fit - ERROR: Troubles defining parameter " << fNames[iP] << std::endl;
+
+    if( fFixed[iP] )
+    {
+      arglist[0] = iP+1;
+      minuit.mnexcm( "FIX", arglist, 1, error );
+    }
+
+  }
+
+  // minimize
+  fCurrent = this;
+  minuit.SetFCN( Fcn );
+
+  arglist[0] = 5000;
+  minuit.mnexcm( "MIGRAD", arglist, 1, error );
+  const int status = error;
+  if( !status ) minuit.mnexcm( "HESSE", arglist, 1, error );
+  fCurrent = 0;
+
+  // store
+  fValues.resize( nPar );
+  fErrors.resize( nPar );
+  for( int iP = 0; iP < nPar; ++iP )
+  { minuit.GetParameter( iP, fValues[iP], fErrors[iP] ); }
+
+  fFcn = Evaluate( &fValues[0] );
+  fNFitPoints = nBins;
+
+  if( !quiet )
+  {
+    std::cout << "TemplateFitter::Fit - status: " << status << " fcn: " << fFcn << " ndf: " << GetNDF() << std::endl;
+    for( int iP = 0; iP < nPar; ++iP )
+    { std::cout << "TemplateFitter::Fit - " << fNames[iP] << ": " << fValues[iP] << " +/- " << fErrors[iP] << std::endl; }
+  }
+
+  return status;
+
+}
+
+//__________________________________________________________________
+TH1* TemplateFitter::GetPrediction( void ) const
+{
+
+  if( fValues.empty() ) return 0;
+
+  TH1* h = Utils::NewClone( Form( "%s_prediction", fHistogram->GetName() ), fHistogram->GetTitle(), fHistogram, kTRUE );
+
+  // recompute prediction and scale factors at minimum
+  Predict( &fValues[0] );
+
+  for( unsigned int i = 0; i < fBins.size(); ++i )
+  {
+    double relVariance = 0;
+    const double beta = GetScaleFactor( i, relVariance );
+    h->SetBinContent( fBins[i], beta*fPrediction[i] );
+    h->SetBinError( fBins[i], beta*TMath::Sqrt( fVariance[i] ) );
+  }
+
+  return h;
+
+}
+
+//__________________________________________________________________
+TH1* TemplateFitter::GetScaledTemplate( int i ) const
+{
+
+  if( i < 0 || i >= int(fValues.size()) ) return 0;
+
+  TH1* h = Utils::NewClone( Form( "%s_scaled", fTemplates[i]->GetName() ), fTemplates[i]->GetTitle(), fTemplates[i], kTRUE );
+  const double* content = &fContent[i*fStride];
+  const double* variance = &fContentVariance[i*fStride];
+  for( unsigned int bin = 0; bin < fBins.size(); ++bin )
+  {
+    h->SetBinContent( fBins[bin], fValues[i]*content[bin] );
+    h->SetBinError( fBins[bin], TMath::Abs( fValues[i] )*TMath::Sqrt( variance[bin] ) );
+  }
+
+  return h;
+
+}
+
+//_____________________________________________________
+void TemplateFitter::Fcn( int& npar, double *gin, double &res, double *par, int flag )
+{
+
+  if( !fCurrent ) {
+    std::cout << "TemplateFitter::Fcn - FATAL: fitter not set" << std::endl;
+    return;
+  }
+
+  res = fCurrent->Evaluate( par );
+  return;
+
+}
@@ -0,0 +1,177 @@
+#ifndef TemplateFitter_h
+#define TemplateFitter_h
+
+/*!
+\file    TemplateFitter.h
+\brief   binned fit of a histogram to a linear combination of template histograms
+*/
+
+#include <TROOT.h>
+#include <TObject.h>
+#include <TString.h>
+
+#include <vector>
+
+class TH1;
+
+/*!
+\class   TemplateFitter
+\brief   binned fit of a histogram to a linear combination of template histograms
+
+Templates are normalized to unit integral over the fit range, and copied once
+into a single contiguous array, one padded row per template. The fitted parameters
+are thus the yields of each template in the fit range. The prediction in each bin is
+accumulated template by template, as a multiply-add over contiguous rows.
+
+The finite statistics of the templates is accounted for using the Barlow-Beeston
+"lite" approach: one nuisance parameter per bin scales the total prediction, and is
+constrained by the relative uncertainty of that prediction. It is solved analytically
+for each bin and each set of yields, so that only the yields are passed to minuit.
+Option "N" disables it.
+
+By default a chisquare is minimized, using data bin errors. Bins with zero error are
+skipped. Option "L" uses a Poisson likelihood instead (-2 log likelihood ratio to the
+saturated model), in which case all bins are used. Option "Q" suppresses printout.
+*/
+class TemplateFitter
+{
+
+  public:
+
+  //! constructor
+  TemplateFitter( TH1* h, TString option = "" );
+
+  //! destructor
+  virtual ~TemplateFitter( void );
+
+  //! add template. Returns template index
+  int AddTemplate( TH1* h, TString name = "" );
+
+  //! initial yield for a given template. Defaults to data integral divided by the number of templates
+  void SetParameter( int i, double value );
+
+  //! fix yield for a given template
+  void FixParameter( int i, double value );
+
+  //! fit. Returns minuit status
+  int Fit( void );
+
+  //! number of templates
+  int GetNParameters( void ) const
+  { return fTemplates.size(); }
+
+  //! template name
+  const TString& GetParameterName( int i ) const
+  { return fNames[i]; }
+
+  //! fitted yield
+  double GetParameter( int i ) const
+  { return fValues[i]; }
+
+  //! fitted yield error
+  double GetParError( int i ) const
+  { return fErrors[i]; }
+
+  //! chisquare or -2 log likelihood ratio at minimum
+  double GetFcn( void ) const
+  { return fFcn; }
+
+  //! number of fitted bins
+  int GetNFitPoints( void ) const
+  { return fNFitPoints; }
+
+  //! number of degrees of freedom
+  int GetNDF( void ) const;
+
+  //! total prediction, including Barlow-Beeston scale factors, at minimum
+  TH1* GetPrediction( void ) const;
+
+  //! a given template, scaled to the fitted yield
+  TH1* GetScaledTemplate( int i ) const;
+
+  private:
+
+  //! minuit function
+  static void Fcn( int& npar, double *gin, double &res, double *par, int flag );
+
+  //! copy data and templates into contiguous arrays
+  bool Initialize( void );
+
+  //! prediction and variance in each fitted bin, stored in fPrediction and fVariance
+  void Predict( const double* par ) const;
+
+  //! Barlow-Beeston scale factor for a given fitted bin, from current prediction. Also returns prediction relative variance
+  double GetScaleFactor( int i, double& relVariance ) const;
+
+  //! chisquare or -2 log likelihood ratio for a given set of yields
+  double Evaluate( const double* par );
+
+  //! data histogram
+  TH1* fHistogram;
+
+  //! fit option
+  TString fOption;
+
+  //! true for likelihood fit, from option
+  bool fLikelihood;
+
+  //! true if template statistical uncertainties are accounted for, from option
+  bool fBarlowBeeston;
+
+  //! templates
+  std::vector<TH1*> fTemplates;
+
+  //! template names
+  std::vector<TString> fNames;
+
+  //! initial yields
+  std::vector<double> fInitial;
+
+  //! true for initial yields set explicitly
+  std::vector<bool> fInitialSet;
+
+  //! true for fixed yields
+  std::vector<bool> fFixed;
+
+  //! fitted yields
+  std::vector<double> fValues;
+
+  //! fitted yield errors
+  std::vector<double> fErrors;
+
+  //! global bin index of fitted bins
+  std::vector<int> fBins;
+
+  //! data content in fitted bins
+  std::vector<double> fData;
+
+  //! data error squared in fitted bins
+  std::vector<double> fDataVariance;
+
+  //! row size in template arrays, padded
+  int fStride;
+
+  //! normalized template contents, one row per template
+  std::vector<double> fContent;
+
+  //! normalized template errors squared, one row per template
+  std::vector<double> fContentVariance;
+
+  //! total prediction in fitted bins, cache updated by Predict
+  mutable std::vector<double> fPrediction;
+
+  //! total prediction variance in fitted bins, cache updated by Predict
+  mutable std::vector<double> fVariance;
+
+  //! fcn at minimum
+  double fFcn;
+
+  //! number of fitted points
+  int fNFitPoints;
+
+  //! fitter being minimized, used by static minuit function
+  static TemplateFitter* fCurrent;
+
+};
+
+#endif
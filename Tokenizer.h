@@ -0,0 +1,106 @@
+#ifndef Tokenizer_h
+#define Tokenizer_h
+
+/*!
+\file    Tokenizer.h
+\brief   in place splitting of text buffers into lines and tokens
+*/
+
+#ifndef __CINT__
+#include <charconv>
+#include <cstring>
+#endif
+
+/*!
+\class   Tokenizer
+\brief   in place splitting of text buffers into lines and tokens
+
+Lines and whitespace separated tokens are returned as pointer ranges into the buffer,
+with no copy and no length limit. Numbers are parsed with std::from_chars, directly
+from the token. As with stream extraction, a leading '+' is accepted, parsing stops
+at the first character that is not part of the number, and a digit or '.' must follow
+the sign, so that tokens such as "nano" or "info" are not read as NaN or infinity.
+ParseExact accepts nan and inf as whole tokens.
+*/
+class Tokenizer
+{
+
+  public:
+
+  #ifndef __CINT__
+
+  //! true for characters that separate tokens, as std::isspace in the C locale
+  static bool IsSpace( char c )
+  { return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r'; }
+
+  //! next line in [cursor, end), without the end of line character. Cursor is moved to the following line
+  static bool NextLine( const char*& cursor, const char* end, const char*& lineBegin, const char*& lineEnd )
+  {
+    if( cursor >= end ) return false;
+    lineBegin = cursor;
+    lineEnd = static_cast<const char*>( memchr( cursor, '\n', end - cursor ) );
+    if( !lineEnd ) lineEnd = end;
+    cursor = lineEnd < end ? lineEnd+1:end;
+    return true;
+  }
+
+  //! next token in [cursor, end). Cursor is moved past the token
+  static bool NextToken( const char*& cursor, const char* end, const char*& tokenBegin, const char*& tokenEnd )
+  {
+    while( cursor < end && IsSpace( *cursor ) ) ++cursor;
+    if( cursor == end ) return false;
+    tokenBegin = cursor;
+    while( cursor < end && !IsSpace( *cursor ) ) ++cursor;
+    tokenEnd = cursor;
+    return true;
+  }
+
+  //! number of tokens in [begin, end)
+  static int CountTokens( const char* begin, const char* end )
+  {
+    int out = 0;
+    const char* tokenBegin;
+    const char* tokenEnd;
+    while( NextToken( begin, end, tokenBegin, tokenEnd ) ) ++out;
+    return out;
+  }
+
+  //! true if line starts with a comment
+  static bool IsComment( const char* lineBegin, const char* lineEnd )
+  { return lineEnd - lineBegin >= 2 && lineBegin[0] == '/' && lineBegin[1] == '/'; }
+
+  //! parse number from [begin, end). Returns false if no character could be parsed, or if the number does not start with a digit or '.'
+  template<typename T> static bool Parse( const char* begin, const char* end, T& value )
+  {
+    if( begin < end && *begin == '+' )
+    {
+      // sign may appear only once
+      if( ++begin < end && ( *begin == '+' || *begin == '-' ) ) return false;
+    }
+
+    // from_chars also reads nan and inf prefixes
+    const char* first = ( begin < end && *begin == '-' ) ? begin+1:begin;
+    if( !( first < end && ( ( *first >= '0' && *first <= '9' ) || *first == '.' ) ) ) return false;
+
+    const std::from_chars_result result = std::from_chars( begin, end, value );
+    return result.ec == std::errc() && result.ptr != begin;
+  }
+
+  //! parse number from [begin, end). Returns false unless the whole range is a number
+  template<typename T> static bool ParseExact( const char* begin, const char* end, T& value )
+  {
+    if( begin < end && *begin == '+' )
+    {
+      // sign may appear only once
+      if( ++begin < end && ( *begin == '+' || *begin == '-' ) ) return false;
+    }
+
+    const std::from_chars_result result = std::from_chars( begin, end, value );
+    return result.ec == std::errc() && result.ptr == end && begin != end;
+  }
+
+  #endif
+
+};
+
+#endif
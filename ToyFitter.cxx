@@ -0,0 +1,198 @@
+#include "ToyFitter.h"
+#include "FitUtils.h"
+#include "Utils.h"
+#include "WorkerPool.h"
+
+#include <TF1.h>
+#include <TH1.h>
+#include <TMath.h>
+#include <TRandom3.h>
+
+#include <algorithm>
+#include <iostream>
+
+/*!
+  \file ToyFitter.cxx
+  \brief fit uncertainty estimation from Poisson fluctuated replicas of a histogram
+*/
+
+namespace
+{
+
+  //____________________________________________
+  //* random seed for a given toy, independent of how toys are split between workers. Never zero
+  UInt_t GetToySeed( unsigned int seed, unsigned int toy )
+  {
+    // splitmix64 finalizer
+    unsigned long long value = ( static_cast<unsigned long long>( seed ) << 32 ) + toy + 0x9e3779b97f4a7c15ULL;
+    value = ( value ^ ( value >> 30 ) )*0xbf58476d1ce4e5b9ULL;
+    value = ( value ^ ( value >> 27 ) )*0x94d049bb133111ebULL;
+    value ^= value >> 31;
+
+    const UInt_t out = static_cast<UInt_t>( value );
+    return out ? out:1;
+  }
+
+}
+
+//__________________________________________________________________
+int ToyFitter::Run( int nToys )
+{
+
+  fNominal.clear();
+  fToys.clear();
+  if( !( fHistogram && fFunction ) )
+  {
+    std::cout << "ToyFitter::Run - histogram or function not set" << std::endl;
+    return 0;
+  }
+
+  if( nToys <= 0 )
+  {
+    std::cout << "ToyFitter::Run - invalid number of toys: " << nToys << std::endl;
+    return 0;
+  }
+
+  // do not draw, do not store function in histograms, do not print
+  const TString option = fOption + "Q0N";
+
+  // nominal fit
+  const int nPar = fFunction->GetNpar();
+  if( UTILS::FitUtils::Fit( fHistogram, fFunction, option ) != 0 )
+  {
+    std::cout << "ToyFitter::Run - nominal fit failed" << std::endl;
+    return 0;
+  }
+
+  for( int iP = 0; iP < nPar; ++iP ) fNominal.push_back( fFunction->GetParameter( iP ) );
+
+  // nominal bin contents, including under and overflow
+  const int nCells = fHistogram->GetNcells();
+  std::vector<double> contents( nCells );
+  for( int bin = 0; bin < nCells; ++bin ) contents[bin] = TMath::Max( fHistogram->GetBinContent( bin ), 0. );
+
+  // fits only run in parallel when neither the fitter nor the minimizer has shared state
+  const bool threadSafe( UTILS::FitUtils::IsThreadSafe( fOption ) );
+  const unsigned int nWorkers = threadSafe ?
+    WorkerPool::GetNWorkers( fNWorkers, nToys ):1;
+  if( !threadSafe && fNWorkers != 1 )
+  { std::cout << "ToyFitter::Run - fitter or minimizer is not thread safe. Using one worker" << std::endl; }
+  if( nWorkers > 1 ) ROOT::EnableThreadSafety();
+
+  std::cout << "ToyFitter::Run - toys: " << nToys << " workers: " << nWorkers << std::endl;
+
+  // one replica histogram and one function per worker, created from the main thread
+  std::vector<TH1*> histograms;
+  std::vector<TF1*> functions;
+  for( unsigned int worker = 0; worker < nWorkers; ++worker )
+  {
+    TH1* h = static_cast<TH1*>( fHistogram->Clone( Form( "%s_toy_%i", fHistogram->GetName(), worker ) ) );
+    h->SetDirectory( 0 );
+    histograms.push_back( h );
+    functions.push_back( static_cast<TF1*>( fFunction->Clone( Form( "%s_toy_%i", fFunction->GetName(), worker ) ) ) );
+  }
+
+  fToys.resize( nToys );
+  WorkerPool::Run( nWorkers, nToys,
+    [&]( unsigned int worker, unsigned int first, unsigned int end )
+    {
+      TRandom3 random;
+      TH1* h = histograms[worker];
+      TF1* f = functions[worker];
+      std::vector<double> counts( nCells );
+      for( unsigned int i = first; i < end; ++i )
+      {
+
+        // generate replica, from a random stream that only depends on the seed and toy index
+        random.SetSeed( GetToySeed( fSeed, i ) );
+        double entries = 0;
+        for( int bin = 0; bin < nCells; ++bin )
+        { entries += ( counts[bin] = random.PoissonD( contents[bin] ) ); }
+
+        h->Reset();
+        for( int bin = 0; bin < nCells; ++bin )
+        {
+          h->SetBinContent( bin, counts[bin] );
+          h->SetBinError( bin, TMath::Sqrt( counts[bin] ) );
+        }
+        h->SetEntries( entries );
+
+        // fit, starting from nominal parameters
+        f->SetParameters( &fNominal[0] );
+        Toy& toy( fToys[i] );
+        toy.fStatus = UTILS::FitUtils::Fit( h, f, option );
+        for( int iP = 0; iP < nPar; ++iP )
+        {
+          toy.fParameters.push_back( f->GetParameter( iP ) );
+          toy.fErrors.push_back( f->GetParError( iP ) );
+        }
+      }
+    } );
+
+  for( auto h:histograms ) delete h;
+  for( auto f:functions ) delete f;
+
+  // restore nominal parameters
+  fFunction->SetParameters( &fNominal[0] );
+
+  const int nValid = std::count_if( fToys.begin(), fToys.end(), []( const Toy& toy ) { return toy.fStatus == 0; } );
+  std::cout << "ToyFitter::Run - successful fits: " << nValid << "/" << nToys << std::endl;
+  return nValid;
+
+}
+
+//__________________________________________________________________
+std::vector<double> ToyFitter::GetValues( int iPar ) const
+{
+  std::vector<double> out;
+  for( const auto& toy:fToys )
+  { if( toy.fStatus == 0 && iPar < int(toy.fParameters.size()) ) out.push_back( toy.fParameters[iPar] ); }
+  return out;
+}
+
+//__________________________________________________________________
+std::vector<double> ToyFitter::GetErrors( int iPar ) const
+{
+  std::vector<double> out;
+  for( const auto& toy:fToys )
+  { if( toy.fStatus == 0 && iPar < int(toy.fErrors.size()) ) out.push_back( toy.fErrors[iPar] ); }
+  return out;
+}
+
+//__________________________________________________________________
+TH1* ToyFitter::GetParameterHistogram( int iPar, int nBins ) const
+{
+
+  const std::vector<double> values( GetValues( iPar ) );
+  if( values.empty() ) return 0;
+
+  // range from values, with margin
+  double min = *std::min_element( values.begin(), values.end() );
+  double max = *std::max_element( values.begin(), values.end() );
+  const double margin = max > min ? 0.05*(max-min):0.5;
+  min -= margin;
+  max += margin;
+
+  const TString name( Form( "%s_toy_par%i", fFunction->GetName(), iPar ) );
+  TH1* h = Utils::NewTH1( name, fFunction->GetParName( iPar ), nBins, min, max );
+  for( const auto& value:values ) h->Fill( value );
+  return h;
+
+}
+
+//__________________________________________________________________
+TH1* ToyFitter::GetPullHistogram( int iPar, int nBins ) const
+{
+
+  const std::vector<double> values( GetValues( iPar ) );
+  const std::vector<double> errors( GetErrors( iPar ) );
+  if( values.empty() ) return 0;
+
+  const TString name( Form( "%s_toy_pull%i", fFunction->GetName(), iPar ) );
+  const TString title( Form( "%s pull", fFunction->GetParName( iPar ) ) );
+  TH1* h = Utils::NewTH1( name, title, nBins, -5, 5 );
+  for( unsigned int i = 0; i < values.size(); ++i )
+  { if( errors[i] > 0 ) h->Fill( ( values[i] - fNominal[iPar] )/errors[i] ); }
+  return h;
+
+}
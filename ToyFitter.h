@@ -0,0 +1,116 @@
+#ifndef ToyFitter_h
+#define ToyFitter_h
+
+/*!
+\file    ToyFitter.h
+\brief   fit uncertainty estimation from Poisson fluctuated replicas of a histogram
+*/
+
+#include <TROOT.h>
+#include <TObject.h>
+#include <TString.h>
+
+#include <vector>
+
+class TF1;
+class TH1;
+
+/*!
+\class   ToyFitter
+\brief   fit uncertainty estimation from Poisson fluctuated replicas of a histogram
+
+The histogram is first fitted. Replicas are then generated by fluctuating each
+bin according to a Poisson distribution, and refitted starting from the nominal
+fit parameters. Each toy uses its own random number stream, derived from the seed
+and the toy index, so that results do not depend on the number of workers.
+Fits are performed using FitUtils::Fit, in quiet mode. Toys are processed in
+parallel when FitUtils::IsThreadSafe, that is with Minuit2 as default minimizer
+and no local fitter.
+*/
+class ToyFitter
+{
+
+  public:
+
+  //! constructor
+  ToyFitter( TH1* h, TF1* f, TString option = "" ):
+    fHistogram( h ),
+    fFunction( f ),
+    fOption( option ),
+    fNWorkers( 0 ),
+    fSeed( 1 )
+  {}
+
+  //! number of workers. Zero means one per hardware thread
+  void SetNWorkers( unsigned int value )
+  { fNWorkers = value; }
+
+  //! random seed. Each toy uses a different stream derived from it
+  void SetSeed( unsigned int value )
+  { fSeed = value; }
+
+  //! fit histogram, then generate and fit nToys replicas. Returns number of successful toy fits, or 0 if nToys is not positive or the nominal fit fails
+  int Run( int nToys );
+
+  //! nominal parameter value
+  double GetNominal( int iPar ) const
+  { return iPar < int(fNominal.size()) ? fNominal[iPar]:0; }
+
+  //! parameter values for all successful toys
+  std::vector<double> GetValues( int iPar ) const;
+
+  //! parameter errors for all successful toys
+  std::vector<double> GetErrors( int iPar ) const;
+
+  //! parameter distribution for successful toys
+  TH1* GetParameterHistogram( int iPar, int nBins = 100 ) const;
+
+  //! pull distribution (toy - nominal)/toy error for successful toys
+  TH1* GetPullHistogram( int iPar, int nBins = 100 ) const;
+
+  private:
+
+  //! fit result for one toy
+  class Toy
+  {
+    public:
+
+    //! constructor
+    Toy( void ):
+      fStatus( -1 )
+    {}
+
+    //! parameters
+    std::vector<double> fParameters;
+
+    //! errors
+    std::vector<double> fErrors;
+
+    //! fit status
+    int fStatus;
+  };
+
+  //! histogram
+  TH1* fHistogram;
+
+  //! function
+  TF1* fFunction;
+
+  //! fit option
+  TString fOption;
+
+  //! number of workers
+  unsigned int fNWorkers;
+
+  //! random seed
+  unsigned int fSeed;
+
+  //! nominal parameters
+  std::vector<double> fNominal;
+
+  //! toys
+  std::vector<Toy> fToys;
+
+};
+
+#endif
@@ -0,0 +1,323 @@
+#ifndef TypedTable_h
+#define TypedTable_h
+
+/*!
+\file    TypedTable.h
+\brief   table with column types fixed at compile time
+*/
+
+#include "MappedFile.h"
+#include "Table.h"
+#include "Tokenizer.h"
+
+#ifndef __CINT__
+#include <array>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#endif
+
+/*!
+\class   TypedTable
+\brief   table with column types fixed at compile time
+
+Columns are stored as a tuple of std::vector, one per template argument, and are
+accessed by compile time index, with no virtual call and no cast:
+
+\code
+TypedTable<int, double, double> table;
+table.Load( "calibration.txt" );
+const std::vector<double>& gains( table.Get<1>() );
+\endcode
+
+Supported types are double, float, int, bool, TString and std::string. Note that bool
+columns are std::vector<bool>, which is bit packed.
+
+Load reads the same files as Table::Load: whitespace separated values, with empty lines
+and lines starting with "//" skipped. Each token is parsed directly to its column type,
+and must be a complete value. Lines with fewer tokens than columns, or with values that
+do not match the column type, are skipped and counted. Extra tokens are ignored.
+Table conversions are not applied.
+
+ToTable and Fill convert from and to Table, for printing and file formats. Fill requires
+each Table column to hold exactly the type of the matching TypedTable column, with
+unsigned char for bool and TString for std::string.
+*/
+#ifndef __CINT__
+template<typename... Cols> class TypedTable
+{
+
+  public:
+
+  //! number of columns
+  static const size_t NColumns = sizeof...( Cols );
+
+  static_assert( NColumns > 0, "TypedTable needs at least one column" );
+
+  //! row type
+  typedef std::tuple<Cols...> row_type;
+
+  //! type of column I
+  template<size_t I> using column_type = typename std::tuple_element<I, row_type>::type;
+
+  //! number of lines
+  size_t GetNLines( void ) const
+  { return std::get<0>( fColumns ).size(); }
+
+  //! values of column I
+  template<size_t I> std::vector< column_type<I> >& Get( void )
+  { return std::get<I>( fColumns ); }
+
+  //! values of column I
+  template<size_t I> const std::vector< column_type<I> >& Get( void ) const
+  { return std::get<I>( fColumns ); }
+
+  //! value of column I at given line
+  template<size_t I> typename std::vector< column_type<I> >::const_reference Get( size_t line ) const
+  { return std::get<I>( fColumns )[line]; }
+
+  //! column name
+  const std::string& GetName( size_t column ) const
+  { return fNames[column]; }
+
+  //! column name
+  void SetName( size_t column, const std::string& name )
+  { fNames[column] = name; }
+
+  //! append row
+  void AddRow( const Cols&... values )
+  { AddRow( row_type( values... ), std::index_sequence_for<Cols...>() ); }
+
+  //! reserve space in all columns
+  void Reserve( size_t size )
+  { Reserve( size, std::index_sequence_for<Cols...>() ); }
+
+  //! remove all rows
+  void Clear( void )
+  { Clear( std::index_sequence_for<Cols...>() ); }
+
+  //! append rows read from a text file. Returns false if the file cannot be read
+  bool Load( const char* filename );
+
+  //! new table with the same columns and names
+  Table* ToTable( void ) const
+  {
+    Table* out = new Table();
+    ToTable( *out, std::index_sequence_for<Cols...>() );
+    return out;
+  }
+
+  //! replace rows and names by the first columns of table. Returns false if a column type does not match
+  bool Fill( const Table& table );
+
+  private:
+
+  //! parse value. Returns false unless the whole token is a number
+  template<typename T> static bool Parse( const char* begin, const char* end, T& value )
+  { return Tokenizer::ParseExact( begin, end, value ); }
+
+  //! parse value. Accepts 0, 1, false and true
+  static bool Parse( const char* begin, const char* end, bool& value )
+  {
+    const std::string token( begin, end );
+    if( token == "1" || token == "true" ) value = true;
+    else if( token == "0" || token == "false" ) value = false;
+    else return false;
+    return true;
+  }
+
+  //! parse value
+  static bool Parse( const char* begin, const char* end, TString& value )
+  {
+    value = TString( begin, end - begin );
+    return true;
+  }
+
+  //! parse value
+  static bool Parse( const char* begin, const char* end, std::string& value )
+  {
+    value.assign( begin, end );
+    return true;
+  }
+
+  //! parse next token into value
+  template<typename T> static bool ParseNext( const char*& cursor, const char* end, T& value )
+  {
+    const char* tokenBegin;
+    const char* tokenEnd;
+    return Tokenizer::NextToken( cursor, end, tokenBegin, tokenEnd ) && Parse( tokenBegin, tokenEnd, value );
+  }
+
+  //! parse all columns of a line
+  template<size_t... I> static bool ParseRow( const char* cursor, const char* end, row_type& row, std::index_sequence<I...> )
+  { return ( ParseNext( cursor, end, std::get<I>( row ) ) && ... ); }
+
+  //! append row
+  template<size_t... I> void AddRow( const row_type& row, std::index_sequence<I...> )
+  { ( std::get<I>( fColumns ).push_back( std::get<I>( row ) ), ... ); }
+
+  //! reserve space in all columns
+  template<size_t... I> void Reserve( size_t size, std::index_sequence<I...> )
+  { ( std::get<I>( fColumns ).reserve( size ), ... ); }
+
+  //! remove all rows
+  template<size_t... I> void Clear( std::index_sequence<I...> )
+  { ( std::get<I>( fColumns ).clear(), ... ); }
+
+  //! append values to a new column
+  template<typename C, typename T> static ColumnBase* NewColumn( const std::vector<T>& values, const std::string& name )
+  {
+    C* out = new C();
+    out->SetName( name.c_str() );
+    out->Reserve( values.size() );
+    for( const auto& value:values ) out->Append( value );
+    return out;
+  }
+
+  //! new table column
+  static ColumnBase* NewColumn( const std::vector<double>& values, const std::string& name )
+  { return NewColumn<ColumnDouble>( values, name ); }
+
+  //! new table column
+  static ColumnBase* NewColumn( const std::vector<float>& values, const std::string& name )
+  { return NewColumn<ColumnFloat>( values, name ); }
+
+  //! new table column
+  static ColumnBase* NewColumn( const std::vector<int>& values, const std::string& name )
+  { return NewColumn<ColumnInt>( values, name ); }
+
+  //! new table column
+  static ColumnBase* NewColumn( const std::vector<bool>& values, const std::string& name )
+  { return NewColumn<ColumnBool>( values, name ); }
+
+  //! new table column
+  static ColumnBase* NewColumn( const std::vector<TString>& values, const std::string& name )
+  { return NewColumn<ColumnString>( values, name ); }
+
+  //! new table column
+  static ColumnBase* NewColumn( const std::vector<std::string>& values, const std::string& name )
+  {
+    ColumnString* out = new ColumnString();
+    out->SetName( name.c_str() );
+    out->Reserve( values.size() );
+    for( const auto& value:values ) out->Append( TString( value.c_str() ) );
+    return out;
+  }
+
+  //! add all columns to table
+  template<size_t... I> void ToTable( Table& table, std::index_sequence<I...> ) const
+  { ( table.AddColumn( NewColumn( std::get<I>( fColumns ), fNames[I] ) ), ... ); }
+
+  //! copy values of a table column. Returns false if the column type does not match
+  template<typename S, typename T> static bool CopyValues( const ColumnBase* column, std::vector<T>& out )
+  {
+    const Column<S>* typed = dynamic_cast<const Column<S>*>( column );
+    if( !typed ) return false;
+    out.assign( typed->GetValues().begin(), typed->GetValues().end() );
+    return true;
+  }
+
+  //! copy values of a table column
+  template<typename T> static bool CopyColumn( const ColumnBase* column, std::vector<T>& out )
+  { return CopyValues<T>( column, out ); }
+
+  //! copy values of a table column, stored as one byte per value
+  static bool CopyColumn( const ColumnBase* column, std::vector<bool>& out )
+  { return CopyValues<unsigned char>( column, out ); }
+
+  //! copy values of a table column, stored as TString
+  static bool CopyColumn( const ColumnBase* column, std::vector<std::string>& out )
+  {
+    const ColumnString* typed = dynamic_cast<const ColumnString*>( column );
+    if( !typed ) return false;
+    out.clear();
+    for( const auto& value:typed->GetValues() ) out.push_back( value.Data() );
+    return true;
+  }
+
+  //! copy values and name of table column I
+  template<size_t I> bool FillColumn( const Table& table )
+  {
+    const ColumnBase* column = table.GetColumn( I );
+    if( !( column && CopyColumn( column, std::get<I>( fColumns ) ) ) )
+    {
+      std::cout << "TypedTable::Fill - type mismatch for column " << I << std::endl;
+      return false;
+    }
+
+    std::get<I>( fColumns ).resize( table.GetNLines() );
+    fNames[I] = column->GetName().Data();
+    return true;
+  }
+
+  //! copy all columns
+  template<size_t... I> bool Fill( const Table& table, std::index_sequence<I...> )
+  { return ( FillColumn<I>( table ) && ... ); }
+
+  //! columns
+  std::tuple< std::vector<Cols>... > fColumns;
+
+  //! column names
+  std::array<std::string, sizeof...( Cols )> fNames;
+
+};
+
+//__________________________________________________________________
+template<typename... Cols> bool TypedTable<Cols...>::Load( const char* filename )
+{
+
+  if( !filename )
+  {
+    std::cout << "TypedTable::Load - empty string." << std::endl;
+    return false;
+  }
+
+  const MappedFile file( filename );
+  if( !file.IsValid() )
+  {
+    std::cout << "TypedTable::Load - cannot open file " << filename << std::endl;
+    return false;
+  }
+
+  int nLines = 0;
+  int nInvalid = 0;
+  row_type row;
+  const char* cursor = file.GetData();
+  const char* lineBegin;
+  const char* lineEnd;
+  while( Tokenizer::NextLine( cursor, file.GetEnd(), lineBegin, lineEnd ) )
+  {
+    if( Tokenizer::IsComment( lineBegin, lineEnd ) ) continue;
+    if( ParseRow( lineBegin, lineEnd, row, std::index_sequence_for<Cols...>() ) )
+    {
+      AddRow( row, std::index_sequence_for<Cols...>() );
+      ++nLines;
+    } else if( Tokenizer::CountTokens( lineBegin, lineEnd ) ) ++nInvalid;
+  }
+
+  std::cout << "TypedTable::Load - " << nLines << " lines read" << std::endl;
+  if( nInvalid ) std::cout << "TypedTable::Load - " << nInvalid << " invalid lines skipped" << std::endl;
+  return true;
+
+}
+
+//__________________________________________________________________
+template<typename... Cols> bool TypedTable<Cols...>::Fill( const Table& table )
+{
+
+  if( table.GetNColumns() < int( NColumns ) )
+  {
+    std::cout << "TypedTable::Fill - table has " << table.GetNColumns() << " columns, " << NColumns << " needed" << std::endl;
+    return false;
+  }
+
+  if( Fill( table, std::index_sequence_for<Cols...>() ) ) return true;
+
+  Clear();
+  return false;
+
+}
+#endif
+
+#endif
@@ -0,0 +1,299 @@
+#include "UnbinnedFitter.h"
+
+#include <TF1.h>
+#include <TMath.h>
+#include <TMinuit.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <iostream>
+
+/*!
+  \file UnbinnedFitter.cxx
+  \brief maximum likelihood fit of a TF1 to event arrays
+*/
+
+//__________________________________
+UnbinnedFitter* UnbinnedFitter::fCurrent = 0;
+
+//___________________________
+UnbinnedFitter::UnbinnedFitter( TF1* f ):
+  fFunction( f ),
+  fBatchFunction( 0 ),
+  fMaxUnbinnedEvents( 100000 ),
+  fNBins( 1000 ),
+  fXMin( 0 ),
+  fXMax( 0 )
+{}
+
+//___________________________
+UnbinnedFitter::~UnbinnedFitter( void )
+{ if( fCurrent == this ) fCurrent = 0; }
+
+//__________________________________________________________________
+int UnbinnedFitter::Fit( const double* events, int n )
+{
+
+  if( !fFunction )
+  {
+    std::cout << "UnbinnedFitter::Fit - FATAL: function not set" << std::endl;
+    return -1;
+  }
+
+  // copy events within function range
+  fFunction->GetRange( fXMin, fXMax );
+  fEvents.clear();
+  fEvents.reserve( n );
+  for( int i = 0; i < n; ++i )
+  { if( events[i] >= fXMin && events[i] <= fXMax ) fEvents.push_back( events[i] ); }
+
+  if( fEvents.empty() )
+  {
+    std::cout << "UnbinnedFitter::Fit - no events in range" << std::endl;
+    return -1;
+  }
+
+  if( int(fEvents.size()) <= fMaxUnbinnedEvents )
+  {
+
+    std::cout << "UnbinnedFitter::Fit - using unbinned likelihood fitter, events: " << fEvents.size() << std::endl;
+    fValues.resize( fEvents.size() );
+    return Minimize();
+
+  } else {
+
+    if( fNBins <= 0 )
+    {
+      std::cout << "UnbinnedFitter::Fit - invalid number of bins: " << fNBins << std::endl;
+      return -1;
+    }
+
+    std::cout << "UnbinnedFitter::Fit - using binned likelihood fitter, events: " << fEvents.size() << std::endl;
+    FillBins();
+
+    // events are not needed anymore
+    std::vector<double>().swap( fEvents );
+    return Minimize();
+
+  }
+
+}
+
+//__________________________________________________________________
+int UnbinnedFitter::Fit( TTree* tree, TString var, TCut cut )
+{
+
+  if( !tree )
+  {
+    std::cout << "UnbinnedFitter::Fit - tree is NULL" << std::endl;
+    return -1;
+  }
+
+  // make sure all selected rows are stored. The tree estimate is restored afterwards
+  const Long64_t estimate = tree->GetEstimate();
+  tree->SetEstimate( tree->GetEntries()+1 );
+  const Long64_t n = tree->Draw( var, cut, "goff" );
+  const int status = n > 0 ? Fit( tree->GetV1(), tree->GetSelectedRows() ):-1;
+  tree->SetEstimate( estimate );
+  return status;
+
+}
+
+//__________________________________________________________________
+void UnbinnedFitter::FillBins( void )
+{
+
+  // bin edges are taken from the quantiles of a sorted sample
+  const int sampleSize = std::min<int>( fEvents.size(), 100*fNBins );
+  const int stride = fEvents.size()/sampleSize;
+  std::vector<double> sample;
+  sample.reserve( sampleSize );
+  for( int i = 0; i < sampleSize; ++i )
+  { sample.push_back( fEvents[i*stride] ); }
+  std::sort( sample.begin(), sample.end() );
+
+  fEdges.clear();
+  fEdges.push_back( fXMin );
+  for( int i = 1; i < fNBins; ++i )
+  {
+    const double edge = sample[ (i*sample.size())/fNBins ];
+    if( edge > fEdges.back() && edge < fXMax ) fEdges.push_back( edge );
+  }
+  fEdges.push_back( fXMax );
+
+  // fill bins
+  fContents.assign( fEdges.size()-1, 0 );
+  for( std::vector<double>::const_iterator iter = fEvents.begin(); iter != fEvents.end(); ++iter )
+  {
+    const int bin = std::upper_bound( fEdges.begin(), fEdges.end(), *iter ) - fEdges.begin() - 1;
+    fContents[ std::min<int>( bin, fContents.size()-1 ) ]++;
+  }
+
+  // edges and centers, interleaved, at which the function is evaluated
+  const int nBins = fContents.size();
+  fPoints.resize( 2*nBins+1 );
+  for( int i = 0; i < nBins; ++i )
+  {
+    fPoints[2*i] = fEdges[i];
+    fPoints[2*i+1] = 0.5*( fEdges[i]+fEdges[i+1] );
+  }
+  fPoints[2*nBins] = fEdges[nBins];
+  fValues.resize( fPoints.size() );
+
+  std::cout << "UnbinnedFitter::FillBins - bins: " << fContents.size() << std::endl;
+
+}
+
+//__________________________________________________________________
+int UnbinnedFitter::Minimize( void )
+{
+
+  const int nPar = fFunction->GetNpar();
+  TMinuit minuit( nPar );
+  minuit.SetPrintLevel( -1 );
+
+  // errors correspond to one unit of -2 log(L)
+  int error = 0;
+  double arglist[2] = { 1, 0 };
+  minuit.mnexcm( "SET ERR", arglist, 1, error );
+
+  for( int iP = 0; iP < nPar; ++iP )
+  {
+
+    const double value = fFunction->GetParameter( iP );
+    double step = fFunction->GetParError( iP );
+    if( step <= 0 ) step = value ? 0.1*TMath::Abs( value ):0.1;
+
+    double min = 0;
+    double max = 0;
+    fFunction->GetParLimits( iP, min, max );
+    const bool fixed( min*max != 0 && min >= max );
+    if( fixed || min >= max ) { min = 0; max = 0; }
+
+    minuit.mnparm( iP, fFunction->GetParName( iP ), value, step, min, max, error );
+    if( error ) std::cout << "UnbinnedFitter::Minimize - ERROR: Troubles defining parameter " << iP << std::endl;
+
+    if( fixed )
+    {
+      arglist[0] = iP+1;
+      minuit.mnexcm( "FIX", arglist, 1, error );
+    }
+
+  }
+
+  // minimize
+  fCurrent = this;
+  minuit.SetFCN( fEdges.empty() ? Fcn:FcnBinned );
+
+  arglist[0] = 5000;
+  minuit.mnexcm( "MIGRAD", arglist, 1, error );
+  const int status = error;
+  if( !status ) minuit.mnexcm( "HESSE", arglist, 1, error );
+  fCurrent = 0;
+
+  // store result
+  for( int iP = 0; iP < nPar; ++iP )
+  {
+    double value = 0;
+    double parError = 0;
+    minuit.GetParameter( iP, value, parError );
+    fFunction->SetParameter( iP, value );
+    fFunction->SetParError( iP, parError );
+  }
+
+  // binned data are not needed anymore
+  fEdges.clear();
+  fContents.clear();
+  fPoints.clear();
+
+  return status;
+
+}
+
+//_____________________________________________________
+void UnbinnedFitter::Evaluate( const std::vector<double>& x, std::vector<double>& values, double* par ) const
+{
+
+  const int n = x.size();
+  if( fBatchFunction ) fBatchFunction( x.data(), values.data(), n, par );
+  else {
+    for( int i = 0; i < n; ++i )
+    {
+      double xi = x[i];
+      values[i] = fFunction->EvalPar( &xi, par );
+    }
+  }
+
+}
+
+//_____________________________________________________
+void UnbinnedFitter::Fcn( int& npar, double *gin, double &res, double *par, int flag )
+{
+
+  if( !fCurrent ) {
+    std::cout << "UnbinnedFitter::Fcn - FATAL: fitter not set" << std::endl;
+    return;
+  }
+
+  TF1* f = fCurrent->fFunction;
+  const std::vector<double>& events = fCurrent->fEvents;
+  std::vector<double>& values = fCurrent->fValues;
+
+  // normalization
+  f->SetParameters( par );
+  const double integral = f->Integral( fCurrent->fXMin, fCurrent->fXMax );
+  if( integral <= 0 )
+  {
+    res = 1e300;
+    return;
+  }
+
+  // evaluate function for all events
+  const int n = events.size();
+  fCurrent->Evaluate( events, values, par );
+
+  // sum log likelihood
+  double sum = 0;
+  for( int i = 0; i < n; ++i )
+  { sum += TMath::Log( TMath::Max( values[i], 1e-300 ) ); }
+
+  res = -2*( sum - n*TMath::Log( integral ) );
+  return;
+
+}
+
+//_____________________________________________________
+void UnbinnedFitter::FcnBinned( int& npar, double *gin, double &res, double *par, int flag )
+{
+
+  if( !fCurrent ) {
+    std::cout << "UnbinnedFitter::FcnBinned - FATAL: fitter not set" << std::endl;
+    return;
+  }
+
+  const std::vector<double>& edges = fCurrent->fEdges;
+  const std::vector<double>& contents = fCurrent->fContents;
+  std::vector<double>& values = fCurrent->fValues;
+
+  // evaluate function at bin edges and centers
+  const int nBins = contents.size();
+  fCurrent->Evaluate( fCurrent->fPoints, values, par );
+
+  // integrate each bin (Simpson) and sum log likelihood
+  double sum = 0;
+  double total = 0;
+  double entries = 0;
+  for( int i = 0; i < nBins; ++i )
+  {
+    const double integral = TMath::Max(
+      ( edges[i+1]-edges[i] )*( values[2*i] + 4*values[2*i+1] + values[2*i+2] )/6,
+      1e-300 );
+    total += integral;
+    entries += contents[i];
+    sum += contents[i]*TMath::Log( integral );
+  }
+
+  res = -2*( sum - entries*TMath::Log( total ) );
+  return;
+
+}
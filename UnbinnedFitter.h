@@ -0,0 +1,125 @@
+#ifndef UnbinnedFitter_h
+#define UnbinnedFitter_h
+
+/*!
+\file    UnbinnedFitter.h
+\brief   maximum likelihood fit of a TF1 to event arrays
+*/
+
+#include <TCut.h>
+#include <TROOT.h>
+#include <TObject.h>
+#include <TString.h>
+
+#include <vector>
+
+class TF1;
+class TMinuit;
+class TTree;
+
+/*!
+\class   UnbinnedFitter
+\brief   maximum likelihood fit of a TF1 to event arrays
+
+The function is used as a (non normalized) probability density over its range.
+Up to fMaxUnbinnedEvents events, an unbinned likelihood fit is performed.
+Above, events are sorted into fNBins adaptive bins with approximately equal
+content, and a binned multinomial likelihood fit is performed instead.
+
+When a batch function is set, for instance one of the UTILS::FitUtils batch
+overloads matching the TF1, it is used to evaluate all events, or all bin edges
+and centers, in one call per minimization step. Otherwise the TF1 is evaluated
+point by point. The TF1 is still used for normalization and parameter settings.
+*/
+class UnbinnedFitter
+{
+
+  public:
+
+  //! batch evaluation function: fills out[i] with f(x[i]) for n points
+  typedef void (*BatchFunction)( const double* x, double* out, int n, const double* par );
+
+  //! constructor
+  UnbinnedFitter( TF1* f );
+
+  //! destructor
+  virtual ~UnbinnedFitter( void );
+
+  //! max number of events for which unbinned fit is used
+  void SetMaxUnbinnedEvents( int value )
+  { fMaxUnbinnedEvents = value; }
+
+  //! number of bins used for binned fits. Must be positive
+  void SetNBins( int value )
+  { fNBins = value; }
+
+  //! batch evaluation of the fitted function, with the same parameters as the TF1
+  void SetBatchFunction( BatchFunction value )
+  { fBatchFunction = value; }
+
+  //! fit events. Returns minuit status
+  int Fit( const std::vector<double>& events )
+  { return Fit( events.empty() ? 0:&events[0], events.size() ); }
+
+  //! fit events. Returns minuit status
+  int Fit( const double* events, int n );
+
+  //! fit variable from tree. Returns minuit status
+  int Fit( TTree* tree, TString var, TCut cut = "" );
+
+  private:
+
+  //! unbinned likelihood
+  static void Fcn( int& npar, double *gin, double &res, double *par, int flag );
+
+  //! binned likelihood
+  static void FcnBinned( int& npar, double *gin, double &res, double *par, int flag );
+
+  //! calculate adaptive bins and their content from events
+  void FillBins( void );
+
+  //! run minuit and store result in function
+  int Minimize( void );
+
+  //! evaluate function at all x, with given parameters
+  void Evaluate( const std::vector<double>& x, std::vector<double>& values, double* par ) const;
+
+  //! function used for the fit
+  TF1* fFunction;
+
+  //! batch evaluation function, if any
+  BatchFunction fBatchFunction;
+
+  //! max number of unbinned events
+  int fMaxUnbinnedEvents;
+
+  //! number of bins for binned fits
+  int fNBins;
+
+  //! fit range
+  double fXMin;
+
+  //! fit range
+  double fXMax;
+
+  //! events within range
+  std::vector<double> fEvents;
+
+  //! work array for function values
+  std::vector<double> fValues;
+
+  //! bin edges, for binned fits
+  std::vector<double> fEdges;
+
+  //! bin contents, for binned fits
+  std::vector<double> fContents;
+
+  //! bin edges and centers, interleaved, for binned fits
+  std::vector<double> fPoints;
+
+  //! fitter being minimized, used by static minuit functions
+  static UnbinnedFitter* fCurrent;
+
+};
+
+#endif
@@ -7,6 +7,10 @@
 #include "GSLError.h"
 #endif
 
+#include "HistogramArithmetic.h"
+#include "HistogramIntegral.h"
+#include "HistogramView.h"
+#include "Reduction.h"
 #include "Stream.h"
 #include "Utils.h"
 
@@ -17,6 +21,7 @@
 #include <TH1.h>
 #include <TH2.h>
 #include <TH3.h>
+#include <THnBase.h>
 #include <TF1.h>
 #include <TMath.h>
 #include <TText.h>
@@ -119,60 +124,19 @@ void Utils::DeleteObject( TString name )
 
 //________________________________________________________________________
 Double_t Utils::GetMean( Double_t* values, Int_t n )
-{
-  Double_t out(0);
-  for( Int_t i = 0; i < n; ++i )
-  { out+=values[i]; }
-  return out/n;
-}
+{ return Reduction::Sum( values, n )/n; }
 
 //________________________________________________________________________
 Double_t Utils::GetRMS( Double_t* values, Int_t n  )
-{
-  Double_t out(0);
-  const Double_t mean( GetMean( values, n ) );
-  for( Int_t i = 0; i < n; ++i )
-  { out+=ROOT_MACRO::SQUARE(values[i] - mean ); }
-
-  return TMath::Sqrt(out/n);
-}
+{ return TMath::Sqrt( Reduction::GetMoments( values, n ).GetVariance() ); }
 
 //________________________________________________________________________
 Double_t Utils::GetMean( Double_t* values, Double_t* errors, Int_t n )
-{
-  Double_t out(0);
-  Double_t weight(0);
-  for( Int_t i=0; i < n; ++i )
-  {
-    if( errors[i] > 0 )
-    {
-      out += values[i]/ROOT_MACRO::SQUARE( errors[i] );
-      weight += 1.0/ROOT_MACRO::SQUARE( errors[i] );
-    }
-  }
-
-  return out/weight;
-}
+{ return Reduction::GetMoments( values, errors, n ).GetMean(); }
 
 //________________________________________________________________________
 Double_t Utils::GetRMS( Double_t* values, Double_t* errors, Int_t n )
-{
-  Double_t out(0);
-  Double_t weight(0);
-  const Double_t mean( GetMean( values, errors, n ) );
-  for( Int_t i=0; i < n; ++i )
-  {
-
-    if( errors[i] > 0 )
-    {
-      out += ROOT_MACRO::SQUARE( values[i] - mean )/ROOT_MACRO::SQUARE( errors[i] );
-      weight += 1.0/ROOT_MACRO::SQUARE( errors[i] );
-    }
-
-  }
-
-  return TMath::Sqrt(out/weight);
-}
+{ return TMath::Sqrt( Reduction::GetMoments( values, errors, n ).GetVariance() ); }
 
 //________________________________________________________________________
 Double_t* Utils::GetRelativeDifference( Double_t* values, Int_t n )
@@ -438,6 +402,21 @@ void UtilsForm( std::ostream &out, TString format, ... )
   return;
 }
 
+namespace
+{
+
+  //__________________________________________________
+  //* copy contents and squared errors through histogram views, mirrored along x on request. Returns false if storage does not match
+  template<class T, class U> bool CopyBins( const TH1* source, TH1* destination, bool mirrored )
+  {
+    const HistogramView<const T> in( source );
+    HistogramView<U> out( destination );
+    if( !( in.IsValid() && out.IsValid() ) ) return false;
+    return mirrored ? out.AssignMirrored( in ):out.Assign( in );
+  }
+
+}
+
 //__________________________________________________
 TH1* Utils::ScaleAxis( TH1* h, Double_t scale )
 {
@@ -452,13 +431,28 @@ TH1* Utils::ScaleAxis( TH1* h, Double_t scale )
   if( xMin > xMax ) std::swap( xMin, xMax );
 
   TH1* hOut =	NewTH1( name.Data(), title.Data(), axis->GetNbins(), xMin, xMax );
-  for( Int_t bin=0; bin < axis->GetNbins()+2; bin++ )
+  hOut->Sumw2();
+
+  // bins map one to one, in reverse order for negative scale, unless the input has variable bins.
+  // Copy directly between storages when possible
+  const bool mirrored( scale < 0 );
+  const bool copied( scale != 0 && h->GetDimension() == 1 && !axis->GetXbins()->GetSize() && h->GetBinErrorOption() == TH1::kNormal && (
+    CopyBins<double, double>( h, hOut, mirrored ) ||
+    CopyBins<double, float>( h, hOut, mirrored ) ||
+    CopyBins<float, double>( h, hOut, mirrored ) ||
+    CopyBins<float, float>( h, hOut, mirrored ) ) );
+
+  if( !copied )
   {
-    Double_t x = scale*axis->GetBinCenter( bin );
-    Int_t dest_bin = hOut->FindBin( x );
-    hOut->SetBinContent( dest_bin, h->GetBinContent( bin ) );
-    hOut->SetBinError( dest_bin, h->GetBinError( bin ) );
+    for( Int_t bin=0; bin < axis->GetNbins()+2; bin++ )
+    {
+      Double_t x = scale*axis->GetBinCenter( bin );
+      Int_t dest_bin = hOut->FindBin( x );
+      hOut->SetBinContent( dest_bin, h->GetBinContent( bin ) );
+      hOut->SetBinError( dest_bin, h->GetBinError( bin ) );
+    }
   }
+
   hOut->SetEntries( h->GetEntries() );
   return hOut;
 
@@ -503,7 +497,10 @@ TH1* Utils::Integrate( TH1* h, bool normalize, bool inverse )
   TString title( h->GetTitle() );
   title += " [Integrated]";
 
-  const auto entries( h->Integral() );
+  // cumulative sums, built once
+  const HistogramIntegral integral( h );
+
+  const auto entries( integral.Integral() );
   TH1* hInt( NewClone( name.Data(), title.Data(), h ) );
   hInt->GetXaxis()->SetTitle( h->GetXaxis()->GetTitle() );
   
@@ -513,8 +510,8 @@ TH1* Utils::Integrate( TH1* h, bool normalize, bool inverse )
 
     //retrieve Integrate
     auto y = inverse ?
-      h->Integral( bin+1, n_bins+1 ):
-      h->Integral( 1, bin+1 );
+      integral.Integral( bin+1, n_bins+1 ):
+      integral.Integral( 1, bin+1 );
     auto error = std::sqrt( y*(1.0-(y/entries)) );
 
     if( normalize ) {
@@ -579,20 +576,20 @@ Double_t Utils::GetEffectiveScale( TH1* h )
   const Int_t nBinsZ = h->GetNbinsZ();
   std::cout << "Utils::GetEffectiveScale - bins: " << nBinsX << ", " << nBinsY << ", " << nBinsZ << std::endl;
 
-  Double_t sumEntries = 0;
-  Double_t sumErrorSquare = 0;
+  Reduction::Accumulator sumEntries;
+  Reduction::Accumulator sumErrorSquare;
   for( Int_t iX = 0; iX < nBinsX; ++iX )
     for( Int_t iY = 0; iY < nBinsY; ++iY )
     for( Int_t iZ = 0; iZ < nBinsZ; ++iZ )
   {
 
     const Int_t bin = h->GetBin( iX+1, iY+1, iZ+1 );
-    sumEntries += h->GetBinContent( bin );
-    sumErrorSquare += ROOT_MACRO::SQUARE( h->GetBinError( bin ) );
+    sumEntries.Add( h->GetBinContent( bin ) );
+    sumErrorSquare.Add( ROOT_MACRO::SQUARE( h->GetBinError( bin ) ) );
 
   }
 
-  return sumEntries/sumErrorSquare;
+  return sumEntries.Get()/sumErrorSquare.Get();
 }
 
 //__________________________________________________
@@ -949,26 +946,28 @@ Int_t Utils::SubtractHistograms(TH1* h1, TH1* h2, TH1* h3)
   UInt_t n2 = h2->GetNbinsX();
   UInt_t n3 = h3->GetNbinsX();
 
-  Double_t sum1( 0 ), sum2( 0 );
   if(!(n1 == n2 && n2 == n3)){
     std::cout << "Utils::SubtractHistograms - Different number of bins.\n";
     std::cout << "	 " << n1 << ", " << n2 << ", " << n3 << std::endl;
     return int(h1->GetEntries()-h2->GetEntries() );
   }
 
-  //loop over bins
-  for(UInt_t i = 1; i < n1+1; i++) {
-
-    Double_t b1= h1->GetBinContent(i); sum1 += b1;
-    Double_t b2= h2->GetBinContent(i); sum2 += b2;
-    h3->SetBinContent(i,b1-b2);
-
-    Double_t e1= ROOT_MACRO::SQUARE(h1->GetBinError(i));
-    Double_t e2= ROOT_MACRO::SQUARE(h2->GetBinError(i));
-
-    h3->SetBinError( i, TMath::Sqrt( e1+e2 ) );
-
-  }
+  std::vector<double> contents1, variances1;
+  std::vector<double> contents2, variances2;
+  std::vector<double> contents3, variances3;
+  HistogramArithmetic::GetContents( h1, contents1, variances1 );
+  HistogramArithmetic::GetContents( h2, contents2, variances2 );
+  HistogramArithmetic::GetContents( h3, contents3, variances3 );
+
+  // bins 1 to n1
+  HistogramArithmetic::Subtract(
+    &contents1[1], &variances1[1],
+    &contents2[1], &variances2[1],
+    &contents3[1], &variances3[1], n1 );
+  HistogramArithmetic::SetContents( h3, &contents3[0], &variances3[0] );
+
+  const Double_t sum1( Reduction::Sum( &contents1[1], n1 ) );
+  const Double_t sum2( Reduction::Sum( &contents2[1], n1 ) );
   return int( sum1 - sum2 );
 }
 
@@ -1039,41 +1038,25 @@ Double_t Utils::DivideHistograms(TH1* h1, TH1* h2, TH1* h3, UInt_t i1, UInt_t i2
     return 0;
   }
 
-  for(UInt_t i = 1; i < n1+1; i++)
-  {
-
-    if( i >= i1 && i< i2+1 ) {
-
-      Double_t b1 = h1->GetBinContent(i);
-      Double_t b2 = h2->GetBinContent(i);
-      Double_t b3 = (b2 != 0) ? b1/b2:0;
-
-      Double_t e3 = 0;
-      if( errorMode == EFF )
-      {
-
-        e3 = (b2 != 0 ) ? TMath::Sqrt( b3*(1-b3)/b2 ):0;
-        if( b1 == b2 && b1 ) e3 =	0.00001;
-        if( b1 == 0 && b2 ) e3 = 0.00001;
+  std::vector<double> contents1, variances1;
+  std::vector<double> contents2, variances2;
+  std::vector<double> contents3, variances3;
+  HistogramArithmetic::GetContents( h1, contents1, variances1 );
+  HistogramArithmetic::GetContents( h2, contents2, variances2 );
+  HistogramArithmetic::GetContents( h3, contents3, variances3 );
 
-      } else {
+  // bins 1 to n1
+  HistogramArithmetic::Divide( &contents1[1], &contents2[1], &contents3[1], &variances3[1], n1, errorMode );
 
-        if( b1 != 0 ) e3 += ROOT_MACRO::SQUARE( 1.0/TMath::Sqrt(b1) );
-        if( b2 != 0 ) e3 += ROOT_MACRO::SQUARE( 1.0/TMath::Sqrt(b2) );
-        e3 = b3*TMath::Sqrt(e3);
-        if( e3 == 0 ) e3 = 0.00001;
-      }
-
-      h3->SetBinContent(i,b3);
-      h3->SetBinError	(i,e3);
-
-    } else {
-
-      h3->SetBinContent(i,0.);
-      h3->SetBinError	(i,0.);
-
-    }
+  // reset bins outside of range
+  for(UInt_t i = 1; i < n1+1; i++)
+  {
+    if( i >= i1 && i< i2+1 ) continue;
+    contents3[i] = 0;
+    variances3[i] = 0;
   }
+
+  HistogramArithmetic::SetContents( h3, &contents3[0], &variances3[0] );
   return ( (Double_t) h1->Integral() / (Double_t) h2->Integral() );
 }
 
@@ -1128,6 +1111,29 @@ TGraphErrors* Utils::DivideTGraphs(TGraphErrors* tg1, TGraphErrors* tg2 )
 
 }
 
+namespace
+{
+
+  //______________________________________________________
+  //* divide histograms with identical binning, for all bins that are not under or overflow
+  Double_t DivideAllBins(TH1* h1, TH1* h2, TH1* h3, Int_t errorMode )
+  {
+
+    std::vector<double> contents1, variances1;
+    std::vector<double> contents2, variances2;
+    std::vector<double> contents3( h3->GetNcells() ), variances3( h3->GetNcells() );
+    HistogramArithmetic::GetContents( h1, contents1, variances1 );
+    HistogramArithmetic::GetContents( h2, contents2, variances2 );
+
+    // all cells are calculated, only bins that are not under or overflow are stored
+    HistogramArithmetic::Divide( &contents1[0], &contents2[0], &contents3[0], &variances3[0], contents3.size(), errorMode );
+    HistogramArithmetic::SetContents( h3, &contents3[0], &variances3[0] );
+
+    return ( (Double_t) h1->Integral() / (Double_t) h2->Integral() );
+  }
+
+}
+
 //______________________________________________________
 Double_t Utils::DivideHistograms2D(TH2* h1, TH2* h2, TH2* h3, Int_t errorMode )
 {
@@ -1154,33 +1160,80 @@ Double_t Utils::DivideHistograms2D(TH2* h1, TH2* h2, TH2* h3, Int_t errorMode )
     return 0;
   }
 
-  for(UInt_t i = 1; i < nx1+1; i++)
+  return DivideAllBins( h1, h2, h3, errorMode );
+
+}
+
+//______________________________________________________
+Double_t Utils::DivideHistograms3D(TH3* h1, TH3* h2, TH3* h3, Int_t errorMode )
+{
+
+  const TH1* histograms[3] = { h1, h2, h3 };
+  for( int i = 1; i < 3; ++i )
   {
-    for(UInt_t j = 1; j < ny1+1; j++)
+    if( histograms[i]->GetNbinsX() != h1->GetNbinsX() ||
+      histograms[i]->GetNbinsY() != h1->GetNbinsY() ||
+      histograms[i]->GetNbinsZ() != h1->GetNbinsZ() )
     {
-      Int_t bin = h1->GetBin( i, j );
-      Double_t b1 = h1->GetBinContent(bin);
-      Double_t b2 = h2->GetBinContent(bin);
-      Double_t b3 = (b2 != 0) ? b1/b2:0;
-
-      Double_t e3 = 0;
-      if( errorMode == EFF )
-      {
-        e3 = (b2 != 0 ) ? TMath::Sqrt( b3*(1-b3)/b2 ):0;
-        if( b1 == b2 && b1 ) e3 =	0.00001;
-      } else {
-        e3 = b3*TMath::Sqrt(
-          ROOT_MACRO::SQUARE( 1.0/TMath::Sqrt(b1) )
-          + ROOT_MACRO::SQUARE( 1.0/TMath::Sqrt(b2) )
-          );
-      }
-      h3->SetBinContent(bin,b3);
-      h3->SetBinError	(bin,e3);
+      std::cout << "Utils::DivideHistograms3D - Different number of bins" << std::endl;
+      return 0;
     }
+  }
+
+  return DivideAllBins( h1, h2, h3, errorMode );
 
+}
+
+//______________________________________________________
+Double_t Utils::DivideHistograms(THnBase* h1, THnBase* h2, THnBase* h3, Int_t errorMode )
+{
+
+  const int nDim = h1->GetNdimensions();
+  if( h2->GetNdimensions() != nDim || h3->GetNdimensions() != nDim )
+  {
+    std::cout << "Utils::DivideHistograms - Different number of dimensions" << std::endl;
+    return 0;
   }
 
-  return ( (Double_t) h1->Integral() / (Double_t) h2->Integral() );
+  // gather filled reference bins, and matching bins in numerator
+  std::vector<Int_t> coordinates( nDim );
+  std::vector<Long64_t> bins;
+  std::vector<double> contents1;
+  std::vector<double> contents2;
+
+  for( Long64_t bin = 0; bin < h2->GetNbins(); ++bin )
+  {
+    const double content2 = h2->GetBinContent( bin, &coordinates[0] );
+    if( content2 == 0 ) continue;
+
+    // do not allocate missing bins in numerator
+    const Long64_t bin1 = h1->GetBin( &coordinates[0], kFALSE );
+    contents1.push_back( bin1 < 0 ? 0:h1->GetBinContent( bin1 ) );
+    contents2.push_back( content2 );
+    bins.push_back( bin );
+  }
+
+  const int n = bins.size();
+  std::vector<double> contents3( n );
+  std::vector<double> variances3( n );
+  HistogramArithmetic::Divide( contents1.data(), contents2.data(), contents3.data(), variances3.data(), n, errorMode );
+
+  // store
+  if( !h3->GetCalculateErrors() ) h3->Sumw2();
+  for( int i = 0; i < n; ++i )
+  {
+    h2->GetBinContent( bins[i], &coordinates[0] );
+    const Long64_t bin3 = h3->GetBin( &coordinates[0], kTRUE );
+    h3->SetBinContent( bin3, contents3[i] );
+    h3->SetBinError2( bin3, variances3[i] );
+  }
+
+  // integrals
+  Reduction::Accumulator sum1;
+  Reduction::Accumulator sum2;
+  for( Long64_t bin = 0; bin < h1->GetNbins(); ++bin ) sum1.Add( h1->GetBinContent( bin ) );
+  for( Long64_t bin = 0; bin < h2->GetNbins(); ++bin ) sum2.Add( h2->GetBinContent( bin ) );
+  return sum1.Get()/sum2.Get();
 
 }
 
@@ -1191,18 +1244,21 @@ TH1* Utils::GetIntegralHistogram( TH1* source, bool inverse, bool include_overfl
   out->SetTitle( Form( "%s, integrated", source->GetTitle() ) );
   out->Reset();
 
-  auto underflow = include_overflow ? source->GetBinContent(0):0;
-  auto overflow = include_overflow ? source->GetBinContent(source->GetNbinsX()+1):0;
+  // cumulative sums, built once
+  const HistogramIntegral integral( source );
+
+  auto underflow = include_overflow ? integral.Integral(0,0):0;
+  auto overflow = include_overflow ? integral.Integral(source->GetNbinsX()+1,source->GetNbinsX()+1):0;
 
   for( int ibin = 0; ibin < source->GetNbinsX(); ++ibin )
   {
     double error = 0;
-    if( inverse ) out->SetBinContent( ibin+1, source->IntegralAndError( ibin+1, source->GetNbinsX(), error ) + overflow );
-    else out->SetBinContent( ibin+1, source->IntegralAndError( 1, ibin+1, error ) + underflow );
+    if( inverse ) out->SetBinContent( ibin+1, integral.IntegralAndError( ibin+1, source->GetNbinsX(), error ) + overflow );
+    else out->SetBinContent( ibin+1, integral.IntegralAndError( 1, ibin+1, error ) + underflow );
     out->SetBinError( ibin+1, error );
   }
 
-  out->Scale( 1./(source->Integral() + underflow + overflow) );
+  out->Scale( 1./(integral.Integral() + underflow + overflow) );
 
   return out;
 }
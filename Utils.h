@@ -25,6 +25,7 @@ class TF1;
 class TH1;
 class TH2;
 class TH3;
+class THnBase;
 class TText;
 class TGraph;
 class TGraphErrors;
@@ -164,7 +165,8 @@ class Utils:public TObject
 
   /**
   returns histogram Integrate between to axis values
-  linearly correct from bin effects
+  linearly correct from bin effects.
+  For repeated calls on the same histogram, use HistogramIntegral or HistogramIntegral2D
   */
   static Double_t Integrate( TH1* h, Double_t xmin, Double_t xmax );
 
@@ -216,7 +218,10 @@ class Utils:public TObject
     Double_t minz = 0,
     Double_t maxz = 1);
 
-  /// create a new clone histogram safely (delete histograms with same name before)
+  /**
+  create a new clone histogram safely (delete histograms with same name before).
+  The clone is owned by the caller. Temporary copies should use a HistogramView on the parent instead
+  */
   static TH1* NewClone(
     TString name,
     TString title,
@@ -230,7 +235,10 @@ class Utils:public TObject
     TH1* parent,
     bool reset );
 
-  /// create a new clone histogram safely (delete histograms with same name before)
+  /**
+  create a new clone histogram safely (delete histograms with same name before).
+  The clone is owned by the caller. Temporary copies should use a HistogramView on the parent instead
+  */
   static TH2* NewClone2D(
     TString name,
     TString title,
@@ -258,11 +266,15 @@ class Utils:public TObject
   /// subtract histogram and function bin/bin; stores the result in an third histo; returns diff of number of entries
   static Int_t SubtractHistograms(TH1* h1, TF1* f, TH1* h3, Double_t min, Double_t max);
 
-  /// divides 2 histograms bin/bin; stores the result in an third histo; returns ratio of the number of entries in the 2 histo
+  /**
+  error modes for histogram division.
+  EFF is binomial, STD is Poisson (uncorrelated), BAYES is the posterior standard deviation for a uniform prior
+  */
   enum ErrorMode
   {
     EFF,
-    STD
+    STD,
+    BAYES
   };
 
   /// divides 2 histograms bin/bin; stores the result in an third histo; returns ratio of the number of entries in the 2 histo
@@ -271,13 +283,19 @@ class Utils:public TObject
   /// divides 2 histograms bin/bin; stores the result in an third histo; returns ratio of the number of entries in the 2 histo
   static Double_t DivideHistograms2D(TH2* hFound, TH2* hRef, TH2* h3, Int_t errorMode = EFF);
 
+  /// divides 2 histograms bin/bin; stores the result in an third histo; returns ratio of the number of entries in the 2 histo
+  static Double_t DivideHistograms3D(TH3* hFound, TH3* hRef, TH3* h3, Int_t errorMode = EFF);
+
+  /// divides 2 n-dimensional histograms bin/bin, for all filled bins of hRef; stores the result in an third histo; returns ratio of the number of entries in the 2 histo
+  static Double_t DivideHistograms(THnBase* hFound, THnBase* hRef, THnBase* h3, Int_t errorMode = EFF);
+
   /// divides 2 histograms bin/bin whith specified range; stores the result in an third histo; returns ratio of the number of entries in the 2 histo
   static Double_t DivideHistograms(TH1* hFound, TH1* hRef, TH1* h3, UInt_t i1, UInt_t i2, Int_t errorMode = EFF);
 
   /// divides too TGraphs point/point; stores the result in 3 TGraph
   static TGraphErrors* DivideTGraphs( TGraphErrors* tg_found, TGraphErrors* tg_ref );
 
-  /// get integral distribution of a given histogram
+  /// get integral distribution of a given histogram. For integrals only, use HistogramIntegral, which allocates no histogram
   static TH1* GetIntegralHistogram( TH1*, bool inverse = true, bool include_overflow = true );
 
   #ifndef __CINT__
@@ -0,0 +1,193 @@
+#ifndef WorkerPool_h
+#define WorkerPool_h
+
+/*!
+\file    WorkerPool.h
+\brief   run contiguous chunks of tasks on worker threads
+*/
+
+#ifndef __CINT__
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+/*!
+\class   WorkerPool
+\brief   run contiguous chunks of tasks on worker threads
+
+The static Run method starts and joins one thread per worker at each call. For
+repeated short calls, for instance once per minimization step, a WorkerPool object
+keeps its threads alive between calls to Execute.
+*/
+class WorkerPool
+{
+
+  public:
+
+  #ifndef __CINT__
+
+  //! task function, called with worker index, first task and end task
+  typedef std::function<void( unsigned int, unsigned int, unsigned int )> Function;
+
+  //! number of workers actually used. Zero means one per hardware thread
+  static unsigned int GetNWorkers( unsigned int nWorkers, unsigned int nTasks )
+  {
+    if( !nWorkers ) nWorkers = std::max( 1U, std::thread::hardware_concurrency() );
+    return std::max( 1U, std::min( nWorkers, nTasks ) );
+  }
+
+  //! first task of a given worker chunk. Computed in 64 bits, so that worker*nTasks does not overflow
+  static unsigned int GetFirstTask( unsigned int worker, unsigned int nTasks, unsigned int nWorkers )
+  { return static_cast<unsigned long long>( worker )*nTasks/nWorkers; }
+
+  /*!
+  split nTasks in contiguous chunks, one per worker, and process them in parallel.
+  Returns when all chunks are processed. With a single worker, the function is
+  called from the current thread
+  */
+  static void Run( unsigned int nWorkers, unsigned int nTasks, const Function& function )
+  {
+    nWorkers = GetNWorkers( nWorkers, nTasks );
+    if( nWorkers == 1 )
+    {
+      function( 0, 0, nTasks );
+      return;
+    }
+
+    std::vector<std::thread> threads;
+    for( unsigned int worker = 0; worker < nWorkers; ++worker )
+    { threads.push_back( std::thread( function, worker, GetFirstTask( worker, nTasks, nWorkers ), GetFirstTask( worker+1, nTasks, nWorkers ) ) ); }
+
+    for( auto& thread:threads ) thread.join();
+  }
+
+  //! constructor. Starts persistent worker threads. Zero means one per hardware thread
+  explicit WorkerPool( unsigned int nWorkers ):
+    fNWorkers( GetNWorkers( nWorkers, std::numeric_limits<unsigned int>::max() ) ),
+    fFunction( 0 ),
+    fNTasks( 0 ),
+    fGeneration( 0 ),
+    fNPending( 0 ),
+    fStop( false )
+  {
+    for( unsigned int worker = 1; worker < fNWorkers; ++worker )
+    { fThreads.push_back( std::thread( &WorkerPool::Loop, this, worker ) ); }
+  }
+
+  //! destructor. Stops worker threads
+  ~WorkerPool( void )
+  {
+    {
+      std::lock_guard<std::mutex> lock( fMutex );
+      fStop = true;
+    }
+    fStart.notify_all();
+    for( auto& thread:fThreads ) thread.join();
+  }
+
+  //! number of workers
+  unsigned int GetNWorkers( void ) const
+  { return fNWorkers; }
+
+  /*!
+  split nTasks in contiguous chunks, one per worker, and process them on the persistent threads.
+  The first chunk is processed from the current thread. Returns when all chunks are processed
+  */
+  void Execute( unsigned int nTasks, const Function& function )
+  {
+    if( fNWorkers == 1 )
+    {
+      function( 0, 0, nTasks );
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock( fMutex );
+      fFunction = &function;
+      fNTasks = nTasks;
+      fNPending = fNWorkers - 1;
+      ++fGeneration;
+    }
+    fStart.notify_all();
+
+    function( 0, 0, GetFirstTask( 1, nTasks, fNWorkers ) );
+
+    std::unique_lock<std::mutex> lock( fMutex );
+    fDone.wait( lock, [this] { return !fNPending; } );
+    fFunction = 0;
+  }
+
+  private:
+
+  //! copy constructor
+  WorkerPool( const WorkerPool& ) = delete;
+
+  //! assignment
+  WorkerPool& operator = ( const WorkerPool& ) = delete;
+
+  //! worker thread loop
+  void Loop( unsigned int worker )
+  {
+    unsigned int generation = 0;
+    while( true )
+    {
+      const Function* function;
+      unsigned int nTasks;
+      {
+        std::unique_lock<std::mutex> lock( fMutex );
+        fStart.wait( lock, [&] { return fStop || fGeneration != generation; } );
+        if( fStop ) return;
+        generation = fGeneration;
+        function = fFunction;
+        nTasks = fNTasks;
+      }
+
+      ( *function )( worker, GetFirstTask( worker, nTasks, fNWorkers ), GetFirstTask( worker+1, nTasks, fNWorkers ) );
+
+      {
+        std::lock_guard<std::mutex> lock( fMutex );
+        if( !--fNPending ) fDone.notify_one();
+      }
+    }
+  }
+
+  //! number of workers, including the calling thread
+  unsigned int fNWorkers;
+
+  //! persistent threads
+  std::vector<std::thread> fThreads;
+
+  //! protects shared state below
+  std::mutex fMutex;
+
+  //! signals a new call, or stop
+  std::condition_variable fStart;
+
+  //! signals that all chunks are processed
+  std::condition_variable fDone;
+
+  //! current function
+  const Function* fFunction;
+
+  //! current number of tasks
+  unsigned int fNTasks;
+
+  //! call counter
+  unsigned int fGeneration;
+
+  //! number of chunks still being processed
+  unsigned int fNPending;
+
+  //! true when threads must stop
+  bool fStop;
+
+  #endif
+
+};
+
+#endif